@@ -0,0 +1,194 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Tiny benchmark harness shared by the suite: runs a workload on N threads, measures
+// throughput and sampled per-operation latency, and reports results as a table, CSV or JSON.
+
+struct LatencySummary {
+    double p50_ns = 0;
+    double p90_ns = 0;
+    double p99_ns = 0;
+    double p999_ns = 0;
+    double max_ns = 0;
+};
+
+struct BenchResult {
+    std::string name;
+    size_t threads = 0;
+    uint64_t ops = 0;
+    double seconds = 0;
+    double mops_per_second = 0;
+    LatencySummary latency;
+};
+
+// Every latency_sample_every-th operation of each thread is timed individually. Two clock reads
+// are a sizeable share of a few-nanosecond operation, so throughput-only runs set it to 0,
+// which turns sampling off and reports zero latencies.
+inline uint64_t latency_sample_every = 16;
+
+// SplitMix64: cheap, stateless per-operation randomness for workloads.
+inline uint64_t Mix(uint64_t value) {
+    value += 0x9E3779B97F4A7C15ull;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+}
+
+inline LatencySummary Summarize(std::vector<uint64_t>& samples) {
+    LatencySummary summary;
+    if (samples.empty()) {
+        return summary;
+    }
+    std::sort(samples.begin(), samples.end());
+    auto at = [&samples](double quantile) {
+        size_t index = static_cast<size_t>(quantile * static_cast<double>(samples.size() - 1));
+        return static_cast<double>(samples[index]);
+    };
+    summary.p50_ns = at(0.5);
+    summary.p90_ns = at(0.9);
+    summary.p99_ns = at(0.99);
+    summary.p999_ns = at(0.999);
+    summary.max_ns = static_cast<double>(samples.back());
+    return summary;
+}
+
+// RunWorkload calls body(thread_index, op_index) ops_per_thread times on every thread.
+// on_thread_start/on_thread_stop run on each worker outside of the measured region.
+template <class Body>
+BenchResult RunWorkload(
+    const std::string& name, size_t threads_count, uint64_t ops_per_thread, Body body,
+    const std::function<void()>& on_thread_start = [] {},
+    const std::function<void()>& on_thread_stop = [] {}) {
+    using Clock = std::chrono::steady_clock;
+    std::vector<std::vector<uint64_t>> samples(threads_count);
+    std::atomic<size_t> ready{0};
+    std::atomic<bool> start{false};
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < threads_count; ++t) {
+        threads.emplace_back([&, t] {
+            on_thread_start();
+            std::vector<uint64_t>& local = samples[t];
+            uint64_t sample_every = latency_sample_every;
+            if (sample_every) {
+                local.reserve(ops_per_thread / sample_every + 1);
+            }
+            ready.fetch_add(1);
+            while (!start.load()) {
+                std::this_thread::yield();
+            }
+            if (!sample_every) {
+                for (uint64_t i = 0; i < ops_per_thread; ++i) {
+                    body(t, i);
+                }
+                on_thread_stop();
+                return;
+            }
+            for (uint64_t i = 0; i < ops_per_thread; ++i) {
+                if (i % sample_every == 0) {
+                    auto begin = Clock::now();
+                    body(t, i);
+                    local.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                        Clock::now() - begin)
+                                        .count());
+                } else {
+                    body(t, i);
+                }
+            }
+            on_thread_stop();
+        });
+    }
+    while (ready.load() != threads_count) {
+        std::this_thread::yield();
+    }
+    auto begin = Clock::now();
+    start.store(true);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    std::chrono::duration<double> elapsed = Clock::now() - begin;
+
+    std::vector<uint64_t> merged;
+    for (auto& local : samples) {
+        merged.insert(merged.end(), local.begin(), local.end());
+    }
+    BenchResult result;
+    result.name = name;
+    result.threads = threads_count;
+    result.ops = threads_count * ops_per_thread;
+    result.seconds = elapsed.count();
+    result.mops_per_second = static_cast<double>(result.ops) / result.seconds / 1e6;
+    result.latency = Summarize(merged);
+    return result;
+}
+
+enum class ReportFormat {
+    kTable,
+    kCsv,
+    kJson,
+};
+
+// ParseReportFormat accepts "table", "csv" and "json".
+inline bool ParseReportFormat(const std::string& name, ReportFormat& format) {
+    if (name == "table") {
+        format = ReportFormat::kTable;
+    } else if (name == "csv") {
+        format = ReportFormat::kCsv;
+    } else if (name == "json") {
+        format = ReportFormat::kJson;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+inline void Report(const std::vector<BenchResult>& results, ReportFormat format, FILE* out) {
+    switch (format) {
+        case ReportFormat::kTable:
+            std::fprintf(out, "%-24s %8s %12s %10s %10s %10s %10s %12s\n", "benchmark", "threads",
+                         "Mops/s", "p50 ns", "p90 ns", "p99 ns", "p99.9 ns", "max ns");
+            for (const auto& r : results) {
+                std::fprintf(out, "%-24s %8zu %12.3f %10.0f %10.0f %10.0f %10.0f %12.0f\n",
+                             r.name.c_str(), r.threads, r.mops_per_second, r.latency.p50_ns,
+                             r.latency.p90_ns, r.latency.p99_ns, r.latency.p999_ns,
+                             r.latency.max_ns);
+            }
+            break;
+        case ReportFormat::kCsv:
+            std::fprintf(out,
+                         "benchmark,threads,ops,seconds,mops_per_second,p50_ns,p90_ns,p99_ns,"
+                         "p999_ns,max_ns\n");
+            for (const auto& r : results) {
+                std::fprintf(out, "%s,%zu,%llu,%.6f,%.6f,%.0f,%.0f,%.0f,%.0f,%.0f\n",
+                             r.name.c_str(), r.threads, static_cast<unsigned long long>(r.ops),
+                             r.seconds, r.mops_per_second, r.latency.p50_ns, r.latency.p90_ns,
+                             r.latency.p99_ns, r.latency.p999_ns, r.latency.max_ns);
+            }
+            break;
+        case ReportFormat::kJson:
+            std::fprintf(out, "{\n  \"hardware_concurrency\": %u,\n  \"results\": [",
+                         std::thread::hardware_concurrency());
+            for (size_t i = 0; i < results.size(); ++i) {
+                const auto& r = results[i];
+                std::fprintf(out,
+                             "%s\n    {\"benchmark\": \"%s\", \"threads\": %zu, \"ops\": %llu, "
+                             "\"seconds\": %.6f, \"mops_per_second\": %.6f, \"latency_ns\": "
+                             "{\"p50\": %.0f, \"p90\": %.0f, \"p99\": %.0f, \"p999\": %.0f, "
+                             "\"max\": %.0f}}",
+                             i ? "," : "", r.name.c_str(), r.threads,
+                             static_cast<unsigned long long>(r.ops), r.seconds, r.mops_per_second,
+                             r.latency.p50_ns, r.latency.p90_ns, r.latency.p99_ns,
+                             r.latency.p999_ns, r.latency.max_ns);
+            }
+            std::fprintf(out, "\n  ]\n}\n");
+            break;
+    }
+}
@@ -0,0 +1,377 @@
+// Unified benchmark suite: runs a comparable workload against every primitive of the repo at a
+// range of thread counts and reports throughput and tail latency.
+//
+// Usage: concurrency_bench [--format=table|csv|json] [--threads=1,2,4,...] [--ops=N]
+//                          [--filter=substring] [--output=file] [--sample-every=N]
+//
+// --sample-every=0 turns latency sampling off for throughput-only runs.
+
+#include "bench.h"
+
+#include "../buffered-channel/buffered_channel.h"
+#include "../counter/sharded_counter.h"
+#include "../fast-queue/mpmc.h"
+#include "../hash-table/concurrent_cache.h"
+#include "../hash-table/concurrent_hash_map.h"
+#include "../hazard-ptr/hazard_ptr.h"
+#include "../mpsc-stack/elimination_stack.h"
+#include "../mpsc-stack/mpsc_stack.h"
+#include "../rw-spinlock/rw_spinlock.h"
+#include "../rw_lock/rw_lock.h"
+#include "../semaphore/sema.h"
+#include "../skip-list/skip_list.h"
+#include "../timerqueue/sharded_timerqueue.h"
+#include "../timerqueue/timerqueue.h"
+#include "../timerqueue/timing_wheel.h"
+#include "../unbuffered-channel/unbuffered_channel.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint64_t kKeys = 1 << 16;
+
+// Keeps results of read-only operations alive so they are not optimized out.
+std::atomic<uint64_t> sink{0};
+
+struct Benchmark {
+    std::string name;
+    // Returns no result when the thread count does not fit the workload.
+    std::function<std::optional<BenchResult>(size_t threads, uint64_t ops)> run;
+};
+
+std::optional<BenchResult> HashMap(size_t threads, uint64_t ops) {
+    ConcurrentHashMap<uint64_t, uint64_t> map;
+    for (uint64_t key = 0; key < kKeys; key += 2) {
+        map.Insert(key, key);
+    }
+    // 80% Find, 10% Insert, 10% Erase over a uniformly random key.
+    return RunWorkload("hash_map", threads, ops, [&](size_t t, uint64_t i) {
+        uint64_t random = Mix(t * ops + i);
+        uint64_t key = random % kKeys;
+        switch ((random >> 32) % 10) {
+            case 0:
+                map.Insert(key, i);
+                break;
+            case 1:
+                map.Erase(key);
+                break;
+            default:
+                sink.fetch_add(map.Find(key).first, std::memory_order_relaxed);
+        }
+    });
+}
+
+std::optional<BenchResult> Cache(size_t threads, uint64_t ops) {
+    ConcurrentCache<uint64_t, uint64_t> cache(kKeys / 4);
+    // Cache-aside loop over a skewed key set: squaring a uniform value favours small keys.
+    return RunWorkload("concurrent_cache", threads, ops, [&](size_t t, uint64_t i) {
+        uint64_t random = Mix(t * ops + i) % kKeys;
+        uint64_t key = random * random / kKeys;
+        if (!cache.Find(key).first) {
+            cache.Insert(key, key);
+        }
+    });
+}
+
+std::optional<BenchResult> SkipList(size_t threads, uint64_t ops) {
+    ConcurrentSkipListMap<uint64_t, uint64_t> map;
+    for (uint64_t key = 0; key < kKeys; key += 2) {
+        map.Insert(key, key);
+    }
+    return RunWorkload("skip_list", threads, ops, [&](size_t t, uint64_t i) {
+        uint64_t random = Mix(t * ops + i);
+        uint64_t key = random % kKeys;
+        switch ((random >> 32) % 10) {
+            case 0:
+                map.Insert(key, i);
+                break;
+            case 1:
+                map.Erase(key);
+                break;
+            default:
+                sink.fetch_add(map.Find(key).first, std::memory_order_relaxed);
+        }
+    });
+}
+
+std::optional<BenchResult> MPMCQueue(size_t threads, uint64_t ops) {
+    MPMCBoundedQueue<uint64_t> queue(1 << 16);
+    return RunWorkload("mpmc_queue", threads, ops, [&](size_t, uint64_t i) {
+        uint64_t value;
+        queue.Enqueue(i);
+        sink.fetch_add(queue.Dequeue(value), std::memory_order_relaxed);
+    });
+}
+
+std::optional<BenchResult> BufferedChannelBench(size_t threads, uint64_t ops) {
+    BufferedChannel<uint64_t> channel(1024);
+    // Every thread sends before it receives, so a receive always has a value to take.
+    return RunWorkload("buffered_channel", threads, ops, [&](size_t, uint64_t i) {
+        channel.Send(i);
+        sink.fetch_add(*channel.Recv(), std::memory_order_relaxed);
+    });
+}
+
+std::optional<BenchResult> UnbufferedChannelBench(size_t threads, uint64_t ops) {
+    if (threads % 2 != 0) {
+        return std::nullopt;
+    }
+    UnbufferedChannel<uint64_t> channel;
+    // Even threads send and odd threads receive, so every send meets exactly one receive.
+    return RunWorkload("unbuffered_channel", threads, ops, [&](size_t t, uint64_t i) {
+        if (t % 2 == 0) {
+            channel.Send(i);
+        } else {
+            sink.fetch_add(*channel.Recv(), std::memory_order_relaxed);
+        }
+    });
+}
+
+std::optional<BenchResult> RWLockBench(size_t threads, uint64_t ops) {
+    RWLock lock;
+    uint64_t value = 0;
+    // 90% readers.
+    return RunWorkload("rw_lock", threads, ops, [&](size_t t, uint64_t i) {
+        if (Mix(t * ops + i) % 10 == 0) {
+            lock.Write([&] { ++value; });
+        } else {
+            lock.Read([&] { sink.fetch_add(value, std::memory_order_relaxed); });
+        }
+    });
+}
+
+std::optional<BenchResult> RWSpinLockBench(size_t threads, uint64_t ops) {
+    RWSpinLock lock;
+    uint64_t value = 0;
+    return RunWorkload("rw_spinlock", threads, ops, [&](size_t t, uint64_t i) {
+        if (Mix(t * ops + i) % 10 == 0) {
+            lock.LockWrite();
+            ++value;
+            lock.UnlockWrite();
+        } else {
+            lock.LockRead();
+            sink.fetch_add(value, std::memory_order_relaxed);
+            lock.UnlockRead();
+        }
+    });
+}
+
+std::optional<BenchResult> SemaphoreBench(size_t threads, uint64_t ops) {
+    // Half of the threads may be inside at once.
+    Semaphore semaphore(static_cast<int>(std::max<size_t>(threads / 2, 1)));
+    return RunWorkload("semaphore", threads, ops, [&](size_t, uint64_t) {
+        semaphore.Enter();
+        semaphore.Leave();
+    });
+}
+
+// Timer queues add an already expired timer and pop one, which measures the queue itself
+// rather than the clock.
+template <class Queue>
+std::optional<BenchResult> TimerBench(const std::string& name, size_t threads, uint64_t ops) {
+    Queue queue;
+    auto past = Queue::Clock::now() - std::chrono::seconds(1);
+    return RunWorkload(name, threads, ops, [&](size_t, uint64_t i) {
+        queue.Add(i, past - std::chrono::microseconds(i % 1024));
+        sink.fetch_add(queue.Pop(), std::memory_order_relaxed);
+    });
+}
+
+template <class Stack>
+std::optional<BenchResult> StackBench(const std::string& name, size_t threads, uint64_t ops) {
+    Stack stack;
+    return RunWorkload(name, threads, ops, [&](size_t, uint64_t i) {
+        stack.Push(i);
+        sink.fetch_add(stack.Pop().has_value(), std::memory_order_relaxed);
+    });
+}
+
+std::optional<BenchResult> HazardPtr(size_t threads, uint64_t ops) {
+    std::atomic<uint64_t*> shared{new uint64_t(0)};
+    // 90% of operations read the shared object under a hazard pointer, the rest replace it.
+    auto result = RunWorkload(
+        "hazard_ptr", threads, ops,
+        [&](size_t t, uint64_t i) {
+            if (Mix(t * ops + i) % 10 == 0) {
+                Retire(shared.exchange(new uint64_t(i)));
+            } else {
+                sink.fetch_add(*Acquire(&shared), std::memory_order_relaxed);
+                Release();
+            }
+        },
+        [] { RegisterThread(); }, [] { UnregisterThread(); });
+    delete shared.load();
+    return result;
+}
+
+// Counters and gauges: every thread updates one shared instance.
+std::optional<BenchResult> AtomicCounter(size_t threads, uint64_t ops) {
+    std::atomic<int64_t> counter{0};
+    return RunWorkload("atomic_counter", threads, ops, [&](size_t, uint64_t) {
+        counter.fetch_add(1, std::memory_order_relaxed);
+    });
+}
+
+std::optional<BenchResult> ShardedCounterBench(size_t threads, uint64_t ops) {
+    ShardedCounter counter;
+    auto result =
+        RunWorkload("sharded_counter", threads, ops, [&](size_t, uint64_t) { counter.Increment(); });
+    sink.fetch_add(counter.Value(), std::memory_order_relaxed);
+    return result;
+}
+
+std::optional<BenchResult> AtomicMax(size_t threads, uint64_t ops) {
+    std::atomic<int64_t> max{0};
+    return RunWorkload("atomic_max", threads, ops, [&](size_t, uint64_t i) {
+        int64_t value = static_cast<int64_t>(i);
+        int64_t current = max.load(std::memory_order_relaxed);
+        while (value > current &&
+               !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    });
+}
+
+std::optional<BenchResult> ShardedMaxBench(size_t threads, uint64_t ops) {
+    ShardedMax max;
+    auto result = RunWorkload("sharded_max", threads, ops, [&](size_t, uint64_t i) {
+        max.Update(static_cast<int64_t>(i));
+    });
+    sink.fetch_add(max.Value(), std::memory_order_relaxed);
+    return result;
+}
+
+const std::vector<Benchmark>& AllBenchmarks() {
+    static const std::vector<Benchmark> benchmarks = {
+        {"hash_map", HashMap},
+        {"concurrent_cache", Cache},
+        {"skip_list", SkipList},
+        {"mpmc_queue", MPMCQueue},
+        {"buffered_channel", BufferedChannelBench},
+        {"unbuffered_channel", UnbufferedChannelBench},
+        {"rw_lock", RWLockBench},
+        {"rw_spinlock", RWSpinLockBench},
+        {"semaphore", SemaphoreBench},
+        {"timer_queue",
+         [](size_t threads, uint64_t ops) {
+             return TimerBench<TimerQueue<uint64_t>>("timer_queue", threads, ops);
+         }},
+        {"timing_wheel",
+         [](size_t threads, uint64_t ops) {
+             return TimerBench<TimingWheel<uint64_t>>("timing_wheel", threads, ops);
+         }},
+        {"sharded_timerqueue",
+         [](size_t threads, uint64_t ops) {
+             return TimerBench<ShardedTimerQueue<uint64_t>>("sharded_timerqueue", threads, ops);
+         }},
+        {"mpsc_stack",
+         [](size_t threads, uint64_t ops) {
+             return StackBench<MPSCStack<uint64_t>>("mpsc_stack", threads, ops);
+         }},
+        {"elimination_stack",
+         [](size_t threads, uint64_t ops) {
+             return StackBench<EliminationStack<uint64_t>>("elimination_stack", threads, ops);
+         }},
+        {"hazard_ptr", HazardPtr},
+        {"atomic_counter", AtomicCounter},
+        {"sharded_counter", ShardedCounterBench},
+        {"atomic_max", AtomicMax},
+        {"sharded_max", ShardedMaxBench},
+    };
+    return benchmarks;
+}
+
+bool ParseFlag(const char* arg, const char* flag, std::string& value) {
+    size_t length = std::strlen(flag);
+    if (std::strncmp(arg, flag, length) != 0 || arg[length] != '=') {
+        return false;
+    }
+    value = arg + length + 1;
+    return true;
+}
+
+std::vector<size_t> ParseThreads(const std::string& list) {
+    std::vector<size_t> threads;
+    size_t begin = 0;
+    while (begin < list.size()) {
+        size_t end = list.find(',', begin);
+        if (end == std::string::npos) {
+            end = list.size();
+        }
+        threads.push_back(std::max<size_t>(std::stoul(list.substr(begin, end - begin)), 1));
+        begin = end + 1;
+    }
+    return threads;
+}
+
+int Usage(const char* program) {
+    std::fprintf(stderr,
+                 "Usage: %s [--format=table|csv|json] [--threads=1,2,4,...] [--ops=N] "
+                 "[--filter=substring] [--output=file] [--sample-every=N]\n",
+                 program);
+    return 1;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    ReportFormat format = ReportFormat::kTable;
+    std::vector<size_t> threads = {1, 2, 4, 8, 16, 32, 64};
+    uint64_t ops = 100000;
+    std::string filter;
+    std::string output;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string value;
+        if (ParseFlag(argv[i], "--format", value)) {
+            if (!ParseReportFormat(value, format)) {
+                return Usage(argv[0]);
+            }
+        } else if (ParseFlag(argv[i], "--threads", value)) {
+            threads = ParseThreads(value);
+        } else if (ParseFlag(argv[i], "--ops", value)) {
+            ops = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (ParseFlag(argv[i], "--filter", value)) {
+            filter = value;
+        } else if (ParseFlag(argv[i], "--output", value)) {
+            output = value;
+        } else if (ParseFlag(argv[i], "--sample-every", value)) {
+            latency_sample_every = std::strtoull(value.c_str(), nullptr, 10);
+        } else {
+            return Usage(argv[0]);
+        }
+    }
+
+    std::vector<BenchResult> results;
+    for (const Benchmark& benchmark : AllBenchmarks()) {
+        if (benchmark.name.find(filter) == std::string::npos) {
+            continue;
+        }
+        for (size_t threads_count : threads) {
+            if (auto result = benchmark.run(threads_count, ops); result.has_value()) {
+                results.push_back(*result);
+                std::fprintf(stderr, "%s x%zu: %.3f Mops/s\n", result->name.c_str(),
+                             result->threads, result->mops_per_second);
+            }
+        }
+    }
+
+    FILE* out = stdout;
+    if (!output.empty()) {
+        out = std::fopen(output.c_str(), "w");
+        if (!out) {
+            std::perror(output.c_str());
+            return 1;
+        }
+    }
+    Report(results, format, out);
+    if (out != stdout) {
+        std::fclose(out);
+    }
+    return 0;
+}
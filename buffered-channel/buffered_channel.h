@@ -9,6 +9,8 @@
 #include <mutex>
 #include <iostream>
 
+#include "../instrumentation/contention.h"
+
 using namespace std::chrono_literals;
 
 template <class T>
@@ -18,8 +20,13 @@ public:
     }
 
     void Send(const T& value) {
-        std::unique_lock send_lock(guard_);
-        send_cv_.wait(send_lock, [this]() { return size_ < n_ || !is_opened_.load(); });
+        ContentionScope scope(stats_);
+        std::unique_lock send_lock = LockCounted(guard_, scope);
+        auto can_send = [this]() { return size_ < n_ || !is_opened_.load(); };
+        if (!can_send()) {
+            scope.Block();
+            send_cv_.wait(send_lock, can_send);
+        }
         if (!is_opened_.load()) {
             receive_cv_.notify_all();
             send_cv_.notify_all();
@@ -32,8 +39,13 @@ public:
     }
 
     std::optional<T> Recv() {
-        std::unique_lock receive_lock(guard_);
-        receive_cv_.wait(receive_lock, [this]() { return size_ > 0 || !is_opened_.load(); });
+        ContentionScope scope(stats_);
+        std::unique_lock receive_lock = LockCounted(guard_, scope);
+        auto can_receive = [this]() { return size_ > 0 || !is_opened_.load(); };
+        if (!can_receive()) {
+            scope.Block();
+            receive_cv_.wait(receive_lock, can_receive);
+        }
         if (!is_opened_.load()) {
             if (size_ == 0) {
                 receive_cv_.notify_all();
@@ -61,6 +73,12 @@ public:
         receive_cv_.notify_all();
     }
 
+    // Every Send and Recv counts as an acquisition; waiting for the lock, for free space or
+    // for a value counts as contention.
+    ContentionSnapshot GetContentionStats() const {
+        return stats_.Snapshot();
+    }
+
 private:
     int size_;
     const int n_;
@@ -69,4 +87,5 @@ private:
     std::mutex guard_;
     std::condition_variable send_cv_;
     std::condition_variable receive_cv_;
+    [[no_unique_address]] ContentionStats stats_;
 };
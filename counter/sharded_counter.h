@@ -0,0 +1,176 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <thread>
+#include <vector>
+
+// Scalable statistics: counters and gauges that are updated by many threads and read rarely.
+//
+// Every thread gets a home shard (round-robin, like ShardedTimerQueue), and each shard sits on
+// its own cache line, so concurrent updates from different threads don't bounce a single line
+// between cores. Reads take a snapshot of all shards and aggregate it.
+
+inline size_t CounterHomeShard() {
+    static std::atomic<size_t> next_thread{0};
+    thread_local size_t thread_index = next_thread.fetch_add(1, std::memory_order_relaxed);
+    return thread_index;
+}
+
+inline size_t DefaultCounterShardsCount() {
+    return std::bit_ceil(std::max(std::thread::hardware_concurrency(), 1u));
+}
+
+// ShardedCounter is a sum of per-shard deltas.
+//
+// A shard folds its delta into a shared total once it reaches flush_threshold in absolute
+// value, so ApproximateValue() is one load that is off by at most ErrorBound() in either
+// direction: unflushed decrements make it too high just as unflushed increments make it too
+// low. Value() adds all the shards to the total; it is exact once concurrent updates have
+// finished, but a read racing with a flush may briefly miss or double count one delta.
+class ShardedCounter {
+public:
+    explicit ShardedCounter(int64_t flush_threshold = kDefaultFlushThreshold,
+                            size_t shards_count = DefaultCounterShardsCount())
+        : flush_threshold_(std::max<int64_t>(flush_threshold, 1)),
+          shards_(std::bit_ceil(std::max<size_t>(shards_count, 1))) {
+    }
+
+    ShardedCounter(const ShardedCounter&) = delete;
+    ShardedCounter& operator=(const ShardedCounter&) = delete;
+
+    void Add(int64_t delta) {
+        std::atomic<int64_t>& local = shards_[CounterHomeShard() & (shards_.size() - 1)].value;
+        int64_t pending = local.fetch_add(delta, std::memory_order_relaxed) + delta;
+        if (pending >= flush_threshold_ || pending <= -flush_threshold_) {
+            // Moves exactly what was seen, so concurrent adds to the same shard are kept.
+            local.fetch_sub(pending, std::memory_order_relaxed);
+            total_.fetch_add(pending, std::memory_order_relaxed);
+        }
+    }
+
+    void Increment() {
+        Add(1);
+    }
+
+    void Decrement() {
+        Add(-1);
+    }
+
+    int64_t Value() const {
+        int64_t value = total_.load(std::memory_order_relaxed);
+        for (int64_t shard : Snapshot()) {
+            value += shard;
+        }
+        return value;
+    }
+
+    int64_t ApproximateValue() const {
+        return total_.load(std::memory_order_relaxed);
+    }
+
+    // ErrorBound is the most the unflushed shards can add up to.
+    int64_t ErrorBound() const {
+        return static_cast<int64_t>(shards_.size()) * (flush_threshold_ - 1);
+    }
+
+    // Snapshot returns the deltas not yet folded into the total, one per shard.
+    std::vector<int64_t> Snapshot() const {
+        std::vector<int64_t> snapshot;
+        snapshot.reserve(shards_.size());
+        for (const Shard& shard : shards_) {
+            snapshot.push_back(shard.value.load(std::memory_order_relaxed));
+        }
+        return snapshot;
+    }
+
+    // Reset zeroes the counter. Updates racing with it may or may not be kept.
+    void Reset() {
+        for (Shard& shard : shards_) {
+            shard.value.store(0, std::memory_order_relaxed);
+        }
+        total_.store(0, std::memory_order_relaxed);
+    }
+
+    static constexpr int64_t kDefaultFlushThreshold = 64;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<int64_t> value{0};
+    };
+
+    const int64_t flush_threshold_;
+    std::vector<Shard> shards_;
+    alignas(64) std::atomic<int64_t> total_{0};
+};
+
+// ShardedGauge tracks the extremum of the values passed to Update(): the maximum with
+// Better = std::greater, the minimum with std::less.
+//
+// Update only writes when the value beats its shard, so a gauge that has settled is read-only
+// and stays in every core's cache.
+template <class Better>
+class ShardedGauge {
+public:
+    explicit ShardedGauge(size_t shards_count = DefaultCounterShardsCount())
+        : shards_(std::bit_ceil(std::max<size_t>(shards_count, 1))) {
+        Reset();
+    }
+
+    ShardedGauge(const ShardedGauge&) = delete;
+    ShardedGauge& operator=(const ShardedGauge&) = delete;
+
+    void Update(int64_t value) {
+        std::atomic<int64_t>& local = shards_[CounterHomeShard() & (shards_.size() - 1)].value;
+        int64_t current = local.load(std::memory_order_relaxed);
+        while (Better()(value, current) &&
+               !local.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    // Value returns the extremum over all updates, or Identity() if there were none.
+    int64_t Value() const {
+        int64_t value = Identity();
+        for (int64_t shard : Snapshot()) {
+            if (Better()(shard, value)) {
+                value = shard;
+            }
+        }
+        return value;
+    }
+
+    std::vector<int64_t> Snapshot() const {
+        std::vector<int64_t> snapshot;
+        snapshot.reserve(shards_.size());
+        for (const Shard& shard : shards_) {
+            snapshot.push_back(shard.value.load(std::memory_order_relaxed));
+        }
+        return snapshot;
+    }
+
+    void Reset() {
+        for (Shard& shard : shards_) {
+            shard.value.store(Identity(), std::memory_order_relaxed);
+        }
+    }
+
+    // Identity is the value every other value beats.
+    static constexpr int64_t Identity() {
+        return Better()(0, 1) ? std::numeric_limits<int64_t>::max()
+                              : std::numeric_limits<int64_t>::min();
+    }
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<int64_t> value;
+    };
+
+    std::vector<Shard> shards_;
+};
+
+using ShardedMax = ShardedGauge<std::greater<int64_t>>;
+using ShardedMin = ShardedGauge<std::less<int64_t>>;
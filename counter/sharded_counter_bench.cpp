@@ -0,0 +1,80 @@
+// Measures increment throughput of a single std::atomic against ShardedCounter, and of a
+// compare-and-swap maximum on a single std::atomic against ShardedMax.
+//
+// Every thread increments the shared counter, or reports an ever growing value to the gauge.
+// Latency sampling is off: timing single operations would cost more than the operations.
+//
+// Usage: sharded_counter_bench [max_threads] [ops_per_thread] [table|csv|json]
+
+#include "sharded_counter.h"
+#include "../bench/bench.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+void Check(bool condition, const char* what) {
+    if (!condition) {
+        std::fprintf(stderr, "%s\n", what);
+        std::exit(1);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t max_threads = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 64;
+    size_t ops_per_thread = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1'000'000;
+    ReportFormat format = ReportFormat::kTable;
+    if (argc > 3 && !ParseReportFormat(argv[3], format)) {
+        std::fprintf(stderr, "Usage: %s [max_threads] [ops_per_thread] [table|csv|json]\n",
+                     argv[0]);
+        return 1;
+    }
+    latency_sample_every = 0;
+    std::vector<BenchResult> results;
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        int64_t expected = static_cast<int64_t>(threads * ops_per_thread);
+
+        std::atomic<int64_t> atomic{0};
+        BenchResult atomic_result =
+            RunWorkload("atomic_counter", threads, ops_per_thread, [&atomic](size_t, uint64_t) {
+                atomic.fetch_add(1, std::memory_order_relaxed);
+            });
+        Check(atomic.load() == expected, "std::atomic lost increments");
+
+        ShardedCounter counter;
+        BenchResult sharded_result =
+            RunWorkload("sharded_counter", threads, ops_per_thread,
+                        [&counter](size_t, uint64_t) { counter.Increment(); });
+        Check(counter.Value() == expected, "ShardedCounter lost increments");
+
+        std::atomic<int64_t> atomic_max{0};
+        BenchResult atomic_max_result =
+            RunWorkload("atomic_max", threads, ops_per_thread, [&atomic_max](size_t, uint64_t i) {
+                int64_t value = static_cast<int64_t>(i);
+                int64_t current = atomic_max.load(std::memory_order_relaxed);
+                while (value > current && !atomic_max.compare_exchange_weak(
+                                              current, value, std::memory_order_relaxed)) {
+                }
+            });
+        Check(atomic_max.load() == static_cast<int64_t>(ops_per_thread) - 1,
+              "std::atomic maximum missed the maximum");
+
+        ShardedMax sharded_max;
+        BenchResult sharded_max_result =
+            RunWorkload("sharded_max", threads, ops_per_thread, [&sharded_max](size_t, uint64_t i) {
+                sharded_max.Update(static_cast<int64_t>(i));
+            });
+        Check(sharded_max.Value() == static_cast<int64_t>(ops_per_thread) - 1,
+              "ShardedMax missed the maximum");
+
+        results.insert(results.end(),
+                       {atomic_result, sharded_result, atomic_max_result, sharded_max_result});
+    }
+    Report(results, format, stdout);
+    return 0;
+}
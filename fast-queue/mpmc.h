@@ -6,6 +6,8 @@
 #include <bit>
 #include <cassert>
 
+#include "../instrumentation/contention.h"
+
 template <class T>
 class MPMCBoundedQueue {
 public:
@@ -20,6 +22,7 @@ public:
     }
 
     bool Enqueue(const T& value) {
+        ContentionScope scope(stats_);
         unsigned int index = end_.load();
         while (true) {
             unsigned int pos = index & mask_;
@@ -35,10 +38,12 @@ public:
             } else {
                 index = end_.load();
             }
+            scope.Spin();
         }
     }
 
     bool Dequeue(T& data) {
+        ContentionScope scope(stats_);
         unsigned int index = begin_.load();
         while (true) {
             unsigned int pos = index & mask_;
@@ -54,9 +59,15 @@ public:
             } else {
                 index = begin_.load();
             }
+            scope.Spin();
         }
     }
 
+    // Every Enqueue and Dequeue counts as an acquisition and every retry of its loop as a spin.
+    ContentionSnapshot GetContentionStats() const {
+        return stats_.Snapshot();
+    }
+
 private:
     struct Element {
         std::atomic<unsigned int> generation;
@@ -68,4 +79,5 @@ private:
     std::atomic<unsigned int> end_ = 0;
     unsigned int mask_ = 0;
     unsigned int max_size_ = 0;
+    [[no_unique_address]] ContentionStats stats_;
 };
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <climits>
+
+// Atomically do the following:
+//    if (*value == expected_value) {
+//        sleep_on_address(value)
+//    }
+inline void FutexWait(int *value, int expected_value) {
+    syscall(SYS_futex, value, FUTEX_WAIT_PRIVATE, expected_value, nullptr, nullptr, 0);
+}
+
+// Wakeup 'count' threads sleeping on address of value(INT_MAX wakes all)
+inline void FutexWake(int *value, int count) {
+    syscall(SYS_futex, value, FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+}
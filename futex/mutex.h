@@ -1,51 +1,45 @@
 #pragma once
 
-//#include <linux/futex.h>
-#include <sys/syscall.h>
-#include <sys/time.h>
-#include <unistd.h>
-
 #include <atomic>
 
-// Atomically do the following:
-//    if (*value == expected_value) {
-//        sleep_on_address(value)
-//    }
-void FutexWait(int *value, int expected_value) {
-    //syscall(SYS_futex, value, FUTEX_WAIT_PRIVATE, expected_value, nullptr, nullptr, 0);
-}
-
-// Wakeup 'count' threads sleeping on address of value(-1 wakes all)
-void FutexWake(int *value, int count) {
-    //syscall(SYS_futex, value, FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
-}
-
-
+#include "futex.h"
+#include "../instrumentation/contention.h"
 
+// Mutex on a single futex word, after Drepper's "Futexes Are Tricky".
+//
+// The word is 0 when unlocked, 1 when locked and 2 when locked with possible sleepers, so an
+// uncontended Unlock never makes a syscall.
 class Mutex {
 public:
-    Mutex() : int_under_atomic_(0), atomic_(int_under_atomic_);
     void Lock() {
-        int temp = 0;
-        if (!atomic_.compare_exchange_strong(temp, 1)) {
-            temp = 0;
-            while (atomic_.compare_exchange_weak(temp, 2) && temp != 0) {
-                int one = 1;
-                if (temp == 2 && !atomic_.compare_exchange_strong(one, 2) && one != 0) {
-                    FutexWait(&int_under_atomic_, 2);
-                }
-            }
+        ContentionScope scope(stats_);
+        int state = 0;
+        if (state_.compare_exchange_strong(state, 1)) {
+            return;
+        }
+        if (state != 2) {
+            state = state_.exchange(2);
+        }
+        while (state != 0) {
+            scope.Block();
+            FutexWait(reinterpret_cast<int*>(&state_), 2);
+            state = state_.exchange(2);
         }
     }
 
     void Unlock() {
-        if (atomic_.fetch_add(-1) != 1) {
-            atomic_.store(0);
+        if (state_.fetch_sub(1) != 1) {
+            state_.store(0);
+            FutexWake(reinterpret_cast<int*>(&state_), 1);
         }
-        FutexWake(atomic_.load(), 1);
+    }
+
+    // A Lock that had to sleep on the futex counts as contended.
+    ContentionSnapshot GetContentionStats() const {
+        return stats_.Snapshot();
     }
 
 private:
-    int int_under_atomic_;
-    std::atomic_ref<int> atomic_;
+    std::atomic<int> state_{0};
+    [[no_unique_address]] ContentionStats stats_;
 };
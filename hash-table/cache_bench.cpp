@@ -0,0 +1,97 @@
+// Hit ratio and throughput of ConcurrentCache under a Zipfian key distribution.
+//
+// Every thread runs a cache-aside loop: look the key up and insert it on a miss.
+//
+// Throughput goes to stdout through the shared report; hit ratio and evictions of every run go
+// to stderr.
+//
+// Usage: cache_bench [max_threads] [ops_per_thread] [table|csv|json]
+
+#include "concurrent_cache.h"
+#include "../bench/bench.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Zipfian generator over [0, n) from Gray et al., "Quickly generating billion-record
+// synthetic databases", as used by YCSB.
+class ZipfianGenerator {
+public:
+    ZipfianGenerator(uint64_t n, double theta) : n_(n), theta_(theta) {
+        for (uint64_t i = 1; i <= n; ++i) {
+            zetan_ += 1.0 / std::pow(static_cast<double>(i), theta);
+        }
+        double zeta2 = 1.0 + 1.0 / std::pow(2.0, theta);
+        alpha_ = 1.0 / (1.0 - theta);
+        eta_ = (1.0 - std::pow(2.0 / static_cast<double>(n), 1.0 - theta)) / (1.0 - zeta2 / zetan_);
+    }
+
+    // Maps a uniform u in [0, 1) to a key.
+    uint64_t operator()(double u) const {
+        double uz = u * zetan_;
+        if (uz < 1.0) {
+            return 0;
+        }
+        if (uz < 1.0 + std::pow(0.5, theta_)) {
+            return 1;
+        }
+        return static_cast<uint64_t>(static_cast<double>(n_) *
+                                     std::pow(eta_ * u - eta_ + 1.0, alpha_));
+    }
+
+private:
+    uint64_t n_;
+    double theta_;
+    double zetan_ = 0;
+    double alpha_;
+    double eta_;
+};
+
+BenchResult Run(const ZipfianGenerator& zipf, size_t capacity, size_t threads_count,
+                size_t ops_per_thread) {
+    ConcurrentCache<uint64_t, uint64_t> cache(capacity);
+    BenchResult result =
+        RunWorkload("cache_" + std::to_string(capacity), threads_count, ops_per_thread,
+                    [&cache, &zipf, ops_per_thread](size_t t, uint64_t i) {
+                        // The top 53 bits of the mixed value as a double in [0, 1).
+                        double u = static_cast<double>(Mix(t * ops_per_thread + i) >> 11) * 0x1p-53;
+                        uint64_t key = zipf(u);
+                        if (!cache.Find(key).first) {
+                            cache.Insert(key, key);
+                        }
+                    });
+    auto stats = cache.GetStats();
+    double hit_ratio =
+        static_cast<double>(stats.hits) / static_cast<double>(stats.hits + stats.misses);
+    std::fprintf(stderr, "%s x%zu: hit ratio %.4f, %llu evictions\n", result.name.c_str(),
+                 threads_count, hit_ratio, static_cast<unsigned long long>(stats.evictions));
+    return result;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t max_threads = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 64;
+    size_t ops_per_thread = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1'000'000;
+    ReportFormat format = ReportFormat::kTable;
+    if (argc > 3 && !ParseReportFormat(argv[3], format)) {
+        std::fprintf(stderr, "Usage: %s [max_threads] [ops_per_thread] [table|csv|json]\n",
+                     argv[0]);
+        return 1;
+    }
+    const uint64_t keys = 1'000'000;
+    ZipfianGenerator zipf(keys, 0.99);
+    std::vector<BenchResult> results;
+    for (size_t capacity : {keys / 100, keys / 10}) {
+        for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+            results.push_back(Run(zipf, capacity, threads, ops_per_thread));
+        }
+    }
+    Report(results, format, stdout);
+    return 0;
+}
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <mutex>
+#include <functional>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+
+#include "concurrent_hash_map.h"
+#include "../counter/sharded_counter.h"
+#include "../instrumentation/contention.h"
+
+// Bounded concurrent cache with sharded CLOCK eviction on top of ConcurrentHashMap.
+//
+// Lookups only go through the hash map's stripe lock and then set the entry's reference bit
+// with a relaxed store, so hits never take a write lock. Each shard owns a ring of slots and a
+// clock hand under its own mutex; inserting into a full shard sweeps the hand, giving
+// referenced entries a second chance and evicting the first unreferenced one.
+template <class K, class V, class Hash = std::hash<K>>
+class ConcurrentCache {
+public:
+    struct Stats {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+    };
+
+public:
+    explicit ConcurrentCache(size_t capacity, size_t shards_count = kDefaultShardsCount,
+                             const Hash& hasher = Hash())
+        : hasher_(hasher),
+          capacity_(std::max<size_t>(capacity, 1)),
+          // Twice the capacity keeps the map below its load factor, so it never rehashes.
+          map_(static_cast<int>(2 * capacity_ + 1),
+               static_cast<int>(std::clamp<size_t>(shards_count, 1, capacity_)), hasher),
+          shards_(std::clamp<size_t>(shards_count, 1, capacity_)) {
+        // The first capacity % shards shards take one extra slot, so the sum is exactly capacity.
+        size_t base = capacity_ / shards_.size();
+        size_t extra = capacity_ % shards_.size();
+        for (size_t i = 0; i < shards_.size(); ++i) {
+            Shard& shard = shards_[i];
+            shard.capacity = base + (i < extra ? 1 : 0);
+            shard.keys.resize(shard.capacity);
+            shard.referenced = std::make_unique<std::atomic<uint8_t>[]>(shard.capacity);
+        }
+    }
+
+    std::pair<bool, V> Find(const K& key) {
+        auto [found, entry] = map_.Find(key);
+        if (!found) {
+            misses_.Increment();
+            return std::make_pair(false, V());
+        }
+        hits_.Increment();
+        // The slot may have been reused by a concurrent eviction; marking its new owner is
+        // harmless.
+        GetShard(key).referenced[entry.slot].store(1, std::memory_order_relaxed);
+        return std::make_pair(true, std::move(entry.value));
+    }
+
+    // Insert adds key or replaces its value, evicting another key of the same shard if full.
+    void Insert(const K& key, const V& value) {
+        Shard& shard = GetShard(key);
+        std::unique_lock lock = LockShard(shard);
+        if (auto [found, entry] = map_.Find(key); found) {
+            map_.InsertOrAssign(key, Entry{value, entry.slot});
+            shard.referenced[entry.slot].store(1, std::memory_order_relaxed);
+            return;
+        }
+        uint32_t slot;
+        if (!shard.free_slots.empty()) {
+            slot = shard.free_slots.back();
+            shard.free_slots.pop_back();
+        } else if (shard.used < shard.capacity) {
+            slot = static_cast<uint32_t>(shard.used++);
+        } else {
+            slot = Evict(shard);
+        }
+        shard.keys[slot] = key;
+        // New entries start unreferenced: a key that is never read again goes first.
+        shard.referenced[slot].store(0, std::memory_order_relaxed);
+        map_.Insert(key, Entry{value, slot});
+    }
+
+    bool Erase(const K& key) {
+        Shard& shard = GetShard(key);
+        std::unique_lock lock = LockShard(shard);
+        auto [found, entry] = map_.Find(key);
+        if (!found) {
+            return false;
+        }
+        map_.Erase(key);
+        shard.keys[entry.slot].reset();
+        shard.free_slots.push_back(entry.slot);
+        return true;
+    }
+
+    void Clear() {
+        for (Shard& shard : shards_) {
+            std::unique_lock lock = LockShard(shard);
+            for (size_t slot = 0; slot < shard.used; ++slot) {
+                if (shard.keys[slot].has_value()) {
+                    map_.Erase(*shard.keys[slot]);
+                    shard.keys[slot].reset();
+                }
+            }
+            shard.used = 0;
+            shard.hand = 0;
+            shard.free_slots.clear();
+        }
+    }
+
+    size_t Size() const {
+        return map_.Size();
+    }
+
+    size_t Capacity() const {
+        return capacity_;
+    }
+
+    // The counters are sharded per thread, so a hit writes no cache line shared with other
+    // threads; reading them sums the shards.
+    Stats GetStats() const {
+        return Stats{static_cast<uint64_t>(hits_.Value()), static_cast<uint64_t>(misses_.Value()),
+                     static_cast<uint64_t>(evictions_.Value())};
+    }
+
+    // Aggregates the eviction shard locks; the underlying map reports its stripe locks and
+    // probes separately through GetMapContentionStats().
+    ContentionSnapshot GetContentionStats() const {
+        ContentionSnapshot snapshot;
+        for (const Shard& shard : shards_) {
+            snapshot += shard.stats.Snapshot();
+        }
+        return snapshot;
+    }
+
+    ContentionSnapshot GetMapContentionStats() const {
+        return map_.GetContentionStats();
+    }
+
+    static const size_t kDefaultShardsCount;
+
+private:
+    struct Entry {
+        V value;
+        uint32_t slot;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::vector<std::optional<K>> keys;
+        std::unique_ptr<std::atomic<uint8_t>[]> referenced;
+        std::vector<uint32_t> free_slots;
+        size_t capacity = 0;
+        size_t used = 0;
+        size_t hand = 0;
+        [[no_unique_address]] ContentionStats stats;
+    };
+
+    Shard& GetShard(const K& key) {
+        // The map picks buckets by the low bits of the hash, so mix before picking shards.
+        uint64_t hash = hasher_(key) * 0x9E3779B97F4A7C15ull;
+        return shards_[(hash >> 32) % shards_.size()];
+    }
+
+    static std::unique_lock<std::mutex> LockShard(Shard& shard) {
+        ContentionScope scope(shard.stats);
+        return LockCounted(shard.mutex, scope);
+    }
+
+    uint32_t Evict(Shard& shard) {
+        while (true) {
+            uint32_t slot = static_cast<uint32_t>(shard.hand);
+            shard.hand = (shard.hand + 1) % shard.capacity;
+            if (shard.referenced[slot].exchange(0, std::memory_order_relaxed)) {
+                continue;
+            }
+            map_.Erase(*shard.keys[slot]);
+            evictions_.Increment();
+            return slot;
+        }
+    }
+
+    Hash hasher_;
+    const size_t capacity_;
+    ConcurrentHashMap<K, Entry, Hash> map_;
+    std::deque<Shard> shards_;
+
+    ShardedCounter hits_;
+    ShardedCounter misses_;
+    ShardedCounter evictions_;
+};
+
+template <class K, class V, class Hash>
+const size_t ConcurrentCache<K, V, Hash>::kDefaultShardsCount = 16;
@@ -0,0 +1,75 @@
+// Correctness checks for ConcurrentCache: concurrent inserts must never grow the cache past its
+// capacity, and the hit, miss and eviction counters must add up.
+
+#include "concurrent_cache.h"
+#include "../test/check.h"
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr int kThreads = 8;
+constexpr uint64_t kInsertsPerThread = 20'000;
+constexpr size_t kCapacity = 1000;
+
+void TestCapacityBound() {
+    ConcurrentCache<uint64_t, uint64_t> cache(kCapacity);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&cache, t] {
+            // Every key is inserted once, so each insert past the capacity evicts another key.
+            for (uint64_t i = 0; i < kInsertsPerThread; ++i) {
+                uint64_t key = i * kThreads + t;
+                cache.Insert(key, key + 1);
+                auto [found, value] = cache.Find(key - (i % 16) * kThreads);
+                CHECK(!found || value == key - (i % 16) * kThreads + 1);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // Size() sums per-thread counters and may overshoot while inserts run, so the bound is
+    // checked once everything has settled.
+    auto stats = cache.GetStats();
+    CHECK(cache.Size() == kCapacity);
+    CHECK(stats.hits + stats.misses == kThreads * kInsertsPerThread);
+    CHECK(stats.evictions == kThreads * kInsertsPerThread - kCapacity);
+}
+
+void TestEraseAndClear() {
+    ConcurrentCache<int, int> cache(4, 1);
+    for (int key = 0; key < 4; ++key) {
+        cache.Insert(key, key);
+    }
+    // A referenced entry gets a second chance, so the first eviction skips key 0.
+    CHECK(cache.Find(0).first);
+    cache.Insert(4, 4);
+    CHECK(cache.Find(0).first);
+    CHECK(!cache.Find(1).first);
+    CHECK(cache.Size() == 4);
+
+    CHECK(cache.Erase(0));
+    CHECK(!cache.Erase(0));
+    cache.Insert(5, 5);
+    CHECK(cache.Size() == 4);
+    CHECK(cache.GetStats().evictions == 1);
+
+    cache.Clear();
+    CHECK(cache.Size() == 0);
+    for (int key = 0; key < 8; ++key) {
+        cache.Insert(key, key);
+        CHECK(cache.Size() <= 4);
+    }
+}
+
+}  // namespace
+
+int main() {
+    TestCapacityBound();
+    TestEraseAndClear();
+    return 0;
+}
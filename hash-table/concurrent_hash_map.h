@@ -10,6 +10,10 @@
 #include <deque>
 #include <iostream>
 #include <atomic>
+#include <algorithm>
+
+#include "../counter/sharded_counter.h"
+#include "../instrumentation/contention.h"
 
 template <class K, class V, class Hash = std::hash<K>>
 class ConcurrentHashMap {
@@ -30,8 +34,7 @@ public:
           thread_size_(expected_threads_count),
           mutexes_(),
           buckets_(),
-          max_bucket_sz_(0),
-          counter_(0) {
+          counter_(kCounterFlushThreshold) {
 
         if (expected_size != kUndefinedSize) {
             buckets_.resize(expected_size);
@@ -45,34 +48,27 @@ public:
     }
 
     bool Insert(const K& key, const V& value) {
-        if (10 * counter_.load() >= 9 * buckets_sz_.load()) {
-            Rehash();
-        }
-        {
-            std::lock_guard<std::mutex> lock(mutexes_[GetMutexNum(key)]);
-            size_t pos = GetBucket(key);
-            std::vector<Pair>& list = buckets_[GetBucket(key)];
-            for (auto [k, v] : list) {
-                if (k == key) {
-                    return false;
-                }
-            }
-            list.push_back({key, value});
-            counter_.fetch_add(1);
-            max_bucket_sz_.store(std::max(buckets_[pos].size(), max_bucket_sz_.load()));
-        }
-        return true;
+        return Emplace(key, value, false);
+    }
+
+    // InsertOrAssign inserts key or overwrites its value in place under the stripe lock, so a
+    // concurrent Find sees the old or the new value but never a missing key.
+    //
+    // Returns true if key was inserted.
+    bool InsertOrAssign(const K& key, const V& value) {
+        return Emplace(key, value, true);
     }
 
     bool Erase(const K& key) {
         {
-            std::lock_guard<std::mutex> lock(mutexes_[GetMutexNum(key)]);
+            auto lock = LockStripe(key);
             std::vector<Pair>& list = buckets_[GetBucket(key)];
             for (size_t i = 0; i < list.size(); ++i) {
                 if (list[i].first == key) {
+                    stats_.RecordProbe(i + 1);
                     std::swap(list[i], list.back());
                     list.pop_back();
-                    counter_.fetch_add(-1);
+                    counter_.Decrement();
                     return true;
                 }
             }
@@ -84,7 +80,7 @@ public:
         for (size_t i = 0; i < thread_size_; ++i) {
             mutexes_[i].lock();
         }
-        counter_.store(0);
+        counter_.Reset();
         buckets_ = std::vector<std::vector<Pair>>(buckets_sz_);
         for (size_t i = 0; i < thread_size_; ++i) {
             mutexes_[thread_size_ - 1 - i].unlock();
@@ -93,14 +89,18 @@ public:
 
     std::pair<bool, V> Find(const K& key) const {
         {
-            std::lock_guard<std::mutex> lock(mutexes_[GetMutexNum(key)]);
+            auto lock = LockStripe(key);
             size_t pos = GetBucket(key);
             const std::vector<Pair>& list = buckets_[pos];
+            size_t probe_length = 0;
             for (auto [k, v] : list) {
+                ++probe_length;
                 if (k == key) {
+                    stats_.RecordProbe(probe_length);
                     return std::make_pair(true, v);
                 }
             }
+            stats_.RecordProbe(probe_length);
         }
         return std::make_pair(false, V());
     }
@@ -120,19 +120,53 @@ public:
     }
 
     size_t Size() const {
-        return counter_.load();
+        // Value() may dip below zero while a shard is being flushed.
+        return static_cast<size_t>(std::max<int64_t>(counter_.Value(), 0));
+    }
+
+    // Acquisitions are stripe lock acquisitions; probes are the entries scanned by Find, by
+    // Insert of a new key and by a successful Erase.
+    ContentionSnapshot GetContentionStats() const {
+        return stats_.Snapshot();
     }
 
     static const int kDefaultConcurrencyLevel;
     static const int kUndefinedSize;
+    static const int64_t kCounterFlushThreshold;
 
 private:
     mutable std::vector<std::vector<Pair>> buckets_;
     mutable std::atomic<size_t> buckets_sz_;
     const size_t thread_size_;
-    std::atomic<size_t> max_bucket_sz_;
-    std::atomic<size_t> counter_;
+    ShardedCounter counter_;
     mutable std::deque<std::mutex> mutexes_;
+    bool Emplace(const K& key, const V& value, bool assign) {
+        // The approximate size touches no per-thread cache lines but may be too high as well
+        // as too low. Its lower bound only delays the rehash a little, and it never exceeds
+        // the real size, so a map sized for its contents (as ConcurrentCache does) never
+        // rehashes.
+        int64_t min_size = counter_.ApproximateValue() - counter_.ErrorBound();
+        if (10 * min_size >= 9 * static_cast<int64_t>(buckets_sz_.load())) {
+            Rehash();
+        }
+        {
+            auto lock = LockStripe(key);
+            std::vector<Pair>& list = buckets_[GetBucket(key)];
+            for (auto& [k, v] : list) {
+                if (k == key) {
+                    if (assign) {
+                        v = value;
+                    }
+                    return false;
+                }
+            }
+            stats_.RecordProbe(list.size());
+            list.push_back({key, value});
+            counter_.Increment();
+        }
+        return true;
+    }
+
     void Rehash() const {
         for (size_t i = 0; i < thread_size_; ++i) {
             mutexes_[i].lock();
@@ -160,7 +194,13 @@ private:
         return GetBucket(key) % thread_size_;
     }
 
+    std::unique_lock<std::mutex> LockStripe(const K& key) const {
+        ContentionScope scope(stats_);
+        return LockCounted(mutexes_[GetMutexNum(key)], scope);
+    }
+
     Hash hasher_;
+    [[no_unique_address]] mutable ContentionStats stats_;
 };
 
 template <class K, class V, class Hash>
@@ -168,3 +208,6 @@ const int ConcurrentHashMap<K, V, Hash>::kDefaultConcurrencyLevel = 8;
 
 template <class K, class V, class Hash>
 const int ConcurrentHashMap<K, V, Hash>::kUndefinedSize = -1;
+
+template <class K, class V, class Hash>
+const int64_t ConcurrentHashMap<K, V, Hash>::kCounterFlushThreshold = 8;
@@ -7,41 +7,40 @@ extern thread_local std::atomic<void*> hazard_ptr{nullptr};
 std::mutex scan_lock;
 
 MPSCStack<RetiredPtr> free_list;
-std::atomic<int> approximate_free_list_size = 0;
+ShardedCounter approximate_free_list_size;
 
 std::mutex threads_lock;
 std::unordered_set<ThreadState*> threads;
 
-void ClearNonHazardPointers(MPSCStack<RetiredPtr>::Node* list, std::vector<void*>& hazard) {
-    using Node = MPSCStack<RetiredPtr>::Node;
+std::vector<RetiredPtr> SnatchFreeList() {
+    std::vector<RetiredPtr> retired;
+    free_list.DequeueAll([&retired](RetiredPtr& ptr) { retired.push_back(std::move(ptr)); });
+    return retired;
+}
+
+void ClearNonHazardPointers(std::vector<RetiredPtr>& retired, std::vector<void*>& hazard) {
     std::less<const void*> tf;
     auto cmp = [&tf](const void* lhv, const void* rhv) -> bool { return tf(lhv, rhv); };
     std::sort(hazard.begin(), hazard.end(), std::function(cmp));
-    Node* cur_node = list;
-    while (cur_node) {
-        RetiredPtr cur_retired_ptr = std::move(cur_node->value);
+    for (RetiredPtr& cur_retired_ptr : retired) {
         void* cur_ptr = cur_retired_ptr.value;
-        if (std::lower_bound(hazard.begin(), hazard.end(), cur_ptr, cmp) == hazard.end()) {
+        if (!std::binary_search(hazard.begin(), hazard.end(), cur_ptr, cmp)) {
             cur_retired_ptr.deleter();
         } else {
             free_list.Push(cur_retired_ptr);
-            approximate_free_list_size.fetch_add(1);
+            approximate_free_list_size.Increment();
         }
-        Node* temp = cur_node;
-        cur_node = cur_node->next;
-        delete temp;
     }
 }
 
 void ScanFreeList() {
-    using Node = MPSCStack<RetiredPtr>::Node;
-    approximate_free_list_size.store(0);
+    approximate_free_list_size.Reset();
     std::unique_lock idk(scan_lock, std::defer_lock_t());
     if (!idk.try_lock()) {
         return;
     }
     {
-        Node* list = free_list.SnatchContents();
+        std::vector<RetiredPtr> retired = SnatchFreeList();
         std::vector<void*> hazard;
         {
             std::unique_lock guard(threads_lock);
@@ -51,6 +50,6 @@ void ScanFreeList() {
                 }
             }
         }
-        ClearNonHazardPointers(list, hazard);
+        ClearNonHazardPointers(retired, hazard);
     }
 }
\ No newline at end of file
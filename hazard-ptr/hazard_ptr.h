@@ -10,59 +10,8 @@
 #include <optional>
 #include <iostream>
 
-template <class T>
-class MPSCStack {
-public:
-    struct Node {
-        T value;
-        Node* next;
-    };
-
-    Node* SnatchContents() {
-        return head_.exchange(nullptr);
-    }
-
-    void Push(const T& value) {
-        Node* old_head = head_.load();
-        Node* new_head = new Node{value, old_head};
-        do {
-            new_head->next = old_head;
-        } while (!head_.compare_exchange_weak(old_head, new_head));
-    }
-
-    std::optional<T> Pop() {
-        Node* old_head = head_.load();
-        Node* new_head;
-        do {
-            if (!old_head) {
-                return std::nullopt;
-            }
-            new_head = old_head->next;
-        } while (!head_.compare_exchange_weak(old_head, new_head));
-        T ans = std::move(old_head->value);
-        delete old_head;
-        return ans;
-    }
-
-    template <class TFn>
-    void DequeueAll(const TFn& cb) {
-        std::optional<T> elem = Pop();
-        while (elem.has_value()) {
-            cb(elem.value());
-            elem = Pop();
-        }
-    }
-
-    ~MPSCStack() {
-        std::optional<T> elem = Pop();
-        while (elem.has_value()) {
-            elem = Pop();
-        }
-    }
-
-private:
-    std::atomic<Node*> head_{nullptr};
-};
+#include "../counter/sharded_counter.h"
+#include "../mpsc-stack/mpsc_stack.h"
 
 extern std::mutex scan_lock;
 
@@ -90,7 +39,7 @@ struct RetiredPtr {
 };
 
 extern MPSCStack<RetiredPtr> free_list;
-extern std::atomic<int> approximate_free_list_size;
+extern ShardedCounter approximate_free_list_size;
 
 extern std::mutex threads_lock;
 extern std::unordered_set<ThreadState*> threads;
@@ -118,8 +67,8 @@ template <class T, class Deleter = std::default_delete<T>>
 void Retire(T* value, Deleter deleter = {}) {
     RetiredPtr retired_ptr(value, deleter);
     free_list.Push(retired_ptr);
-    approximate_free_list_size.fetch_add(1);
-    if (approximate_free_list_size.load() > 1024) {
+    approximate_free_list_size.Increment();
+    if (approximate_free_list_size.ApproximateValue() > 1024) {
         ScanFreeList();
     }
 }
@@ -132,7 +81,9 @@ inline void RegisterThread() {
     }
 }
 
-void ClearNonHazardPointers(MPSCStack<RetiredPtr>::Node* list, std::vector<void*>& hazard);
+std::vector<RetiredPtr> SnatchFreeList();
+
+void ClearNonHazardPointers(std::vector<RetiredPtr>& retired, std::vector<void*>& hazard);
 
 inline void UnregisterThread() {
     std::lock_guard<std::mutex> lock_guard(threads_lock);
@@ -143,7 +94,8 @@ inline void UnregisterThread() {
             delete ts;
             if (threads.empty()) {
                 std::vector<void*> dummy;
-                ClearNonHazardPointers(free_list.SnatchContents(), dummy);
+                std::vector<RetiredPtr> retired = SnatchFreeList();
+                ClearNonHazardPointers(retired, dummy);
             }
             return;
         }
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <type_traits>
+
+// Opt-in contention instrumentation for the locks and queues of this repo.
+//
+// Build with CONCURRENCY_INSTRUMENTATION defined (the CMake option of the same name) and every
+// instrumented primitive counts, per instance, how often it was acquired, how many of those
+// acquisitions had to retry or block, how many retries they took and how long they waited.
+// Hash maps additionally record how many entries each lookup had to scan. GetContentionStats()
+// on the primitive returns a ContentionSnapshot of these counters.
+//
+// Without the macro ContentionStats and ContentionScope are empty classes with empty inline
+// methods, held through [[no_unique_address]], so primitives keep their layout and code.
+// The macro must be the same for the whole program: it changes the layout of the primitives.
+
+#ifdef CONCURRENCY_INSTRUMENTATION
+inline constexpr bool kContentionInstrumentation = true;
+#else
+inline constexpr bool kContentionInstrumentation = false;
+#endif
+
+// Bucket i of the wait histogram counts waits of [2^i, 2^(i + 1)) nanoseconds, bucket 0 also
+// counts shorter ones and the last bucket everything longer.
+inline constexpr size_t kWaitBuckets = 32;
+
+struct ContentionSnapshot {
+    uint64_t acquisitions = 0;
+    uint64_t contended = 0;
+    uint64_t spins = 0;
+    uint64_t wait_ns = 0;
+    std::array<uint64_t, kWaitBuckets> wait_histogram{};
+    uint64_t probes = 0;
+    uint64_t probe_length = 0;
+    uint64_t max_probe_length = 0;
+
+    // Merges the counters of another instance, e.g. to aggregate a family of primitives.
+    ContentionSnapshot& operator+=(const ContentionSnapshot& other) {
+        acquisitions += other.acquisitions;
+        contended += other.contended;
+        spins += other.spins;
+        wait_ns += other.wait_ns;
+        for (size_t i = 0; i < kWaitBuckets; ++i) {
+            wait_histogram[i] += other.wait_histogram[i];
+        }
+        probes += other.probes;
+        probe_length += other.probe_length;
+        max_probe_length = std::max(max_probe_length, other.max_probe_length);
+        return *this;
+    }
+};
+
+class ActiveContentionStats {
+public:
+    void RecordAcquisition(uint64_t spins, bool contended, std::chrono::nanoseconds wait) {
+        acquisitions_.fetch_add(1, std::memory_order_relaxed);
+        if (!contended) {
+            return;
+        }
+        contended_.fetch_add(1, std::memory_order_relaxed);
+        spins_.fetch_add(spins, std::memory_order_relaxed);
+        uint64_t ns = wait.count() > 0 ? static_cast<uint64_t>(wait.count()) : 0;
+        wait_ns_.fetch_add(ns, std::memory_order_relaxed);
+        size_t bucket = std::min<size_t>(ns ? std::bit_width(ns) - 1 : 0, kWaitBuckets - 1);
+        wait_histogram_[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void RecordProbe(size_t length) {
+        probes_.fetch_add(1, std::memory_order_relaxed);
+        probe_length_.fetch_add(length, std::memory_order_relaxed);
+        uint64_t max = max_probe_length_.load(std::memory_order_relaxed);
+        while (length > max && !max_probe_length_.compare_exchange_weak(max, length)) {
+        }
+    }
+
+    // The counters are read one by one, so a snapshot taken under load is only approximately
+    // consistent.
+    ContentionSnapshot Snapshot() const {
+        ContentionSnapshot snapshot;
+        snapshot.acquisitions = acquisitions_.load(std::memory_order_relaxed);
+        snapshot.contended = contended_.load(std::memory_order_relaxed);
+        snapshot.spins = spins_.load(std::memory_order_relaxed);
+        snapshot.wait_ns = wait_ns_.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < kWaitBuckets; ++i) {
+            snapshot.wait_histogram[i] = wait_histogram_[i].load(std::memory_order_relaxed);
+        }
+        snapshot.probes = probes_.load(std::memory_order_relaxed);
+        snapshot.probe_length = probe_length_.load(std::memory_order_relaxed);
+        snapshot.max_probe_length = max_probe_length_.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+
+    void Reset() {
+        for (auto* counter : {&acquisitions_, &contended_, &spins_, &wait_ns_, &probes_,
+                              &probe_length_, &max_probe_length_}) {
+            counter->store(0, std::memory_order_relaxed);
+        }
+        for (auto& bucket : wait_histogram_) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    std::atomic<uint64_t> acquisitions_{0};
+    std::atomic<uint64_t> contended_{0};
+    std::atomic<uint64_t> spins_{0};
+    std::atomic<uint64_t> wait_ns_{0};
+    std::array<std::atomic<uint64_t>, kWaitBuckets> wait_histogram_{};
+    std::atomic<uint64_t> probes_{0};
+    std::atomic<uint64_t> probe_length_{0};
+    std::atomic<uint64_t> max_probe_length_{0};
+};
+
+// ActiveContentionScope follows a single acquisition: the first Spin() or Block() starts the
+// wait clock, and the destructor records the acquisition.
+class ActiveContentionScope {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit ActiveContentionScope(ActiveContentionStats& stats) : stats_(stats) {
+    }
+
+    ActiveContentionScope(const ActiveContentionScope&) = delete;
+    ActiveContentionScope& operator=(const ActiveContentionScope&) = delete;
+
+    ~ActiveContentionScope() {
+        std::chrono::nanoseconds wait{0};
+        if (contended_) {
+            wait = Clock::now() - start_;
+        }
+        stats_.RecordAcquisition(spins_, contended_, wait);
+    }
+
+    // Spin records one failed attempt (a lost CAS or a polling round).
+    void Spin() {
+        Contend();
+        ++spins_;
+    }
+
+    // Block records that the caller is about to sleep.
+    void Block() {
+        Contend();
+    }
+
+private:
+    void Contend() {
+        if (!contended_) {
+            contended_ = true;
+            start_ = Clock::now();
+        }
+    }
+
+    ActiveContentionStats& stats_;
+    uint64_t spins_ = 0;
+    bool contended_ = false;
+    Clock::time_point start_;
+};
+
+class NullContentionStats {
+public:
+    void RecordProbe(size_t) {
+    }
+
+    ContentionSnapshot Snapshot() const {
+        return {};
+    }
+
+    void Reset() {
+    }
+};
+
+class NullContentionScope {
+public:
+    explicit NullContentionScope(NullContentionStats&) {
+    }
+
+    void Spin() {
+    }
+
+    void Block() {
+    }
+};
+
+using ContentionStats = std::conditional_t<kContentionInstrumentation, ActiveContentionStats,
+                                           NullContentionStats>;
+using ContentionScope = std::conditional_t<kContentionInstrumentation, ActiveContentionScope,
+                                           NullContentionScope>;
+
+// LockCounted locks mutex, treating a failed try_lock as contention of scope.
+template <class Mutex>
+std::unique_lock<Mutex> LockCounted(Mutex& mutex, ContentionScope& scope) {
+    if constexpr (kContentionInstrumentation) {
+        std::unique_lock lock(mutex, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            scope.Block();
+            lock.lock();
+        }
+        return lock;
+    } else {
+        return std::unique_lock(mutex);
+    }
+}
+
+// AcquireCounted is LockCounted for semaphores.
+template <class TSemaphore>
+void AcquireCounted(TSemaphore& semaphore, ContentionScope& scope) {
+    if constexpr (kContentionInstrumentation) {
+        if (!semaphore.try_acquire()) {
+            scope.Block();
+            semaphore.acquire();
+        }
+    } else {
+        semaphore.acquire();
+    }
+}
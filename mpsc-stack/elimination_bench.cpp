@@ -0,0 +1,51 @@
+// Measures push/pop throughput of the plain Treiber stack against EliminationStack.
+//
+// Every thread alternates Push and Pop on a shared, pre-filled stack.
+//
+// Usage: elimination_bench [max_threads] [ops_per_thread] [table|csv|json]
+
+#include "mpsc_stack.h"
+#include "elimination_stack.h"
+#include "../bench/bench.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+template <class Stack>
+BenchResult Run(const std::string& name, size_t threads, size_t ops_per_thread) {
+    Stack stack;
+    for (int i = 0; i < 1024; ++i) {
+        stack.Push(i);
+    }
+    return RunWorkload(name, threads, ops_per_thread, [&stack](size_t, uint64_t i) {
+        if (i % 2 == 0) {
+            stack.Push(static_cast<int>(i));
+        } else {
+            stack.Pop();
+        }
+    });
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t max_threads = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 64;
+    size_t ops_per_thread = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1'000'000;
+    ReportFormat format = ReportFormat::kTable;
+    if (argc > 3 && !ParseReportFormat(argv[3], format)) {
+        std::fprintf(stderr, "Usage: %s [max_threads] [ops_per_thread] [table|csv|json]\n",
+                     argv[0]);
+        return 1;
+    }
+    std::vector<BenchResult> results;
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        results.push_back(Run<MPSCStack<int>>("treiber_stack", threads, ops_per_thread));
+        results.push_back(Run<EliminationStack<int>>("elimination_stack", threads, ops_per_thread));
+    }
+    Report(results, format, stdout);
+    return 0;
+}
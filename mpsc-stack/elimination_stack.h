@@ -0,0 +1,167 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+#include "mpsc_stack.h"
+#include "../instrumentation/contention.h"
+#include "../random/xorshift.h"
+
+// Lock-free stack with an elimination-backoff layer in front of MPSCStack.
+//
+// A thread that loses the CAS on the stack head goes to a random slot of the elimination array
+// and waits there briefly for an opposite operation: a push and a pop that meet exchange the
+// value directly and never touch the head. The part of the array in use grows when threads
+// collide on slots and shrinks when they time out waiting alone.
+template <class T>
+class EliminationStack {
+public:
+    explicit EliminationStack(size_t max_slots = std::max(1u, std::thread::hardware_concurrency()))
+        : slots_(std::max<size_t>(max_slots, 1)) {
+    }
+
+    // Push adds one element to stack top.
+    //
+    // Safe to call from multiple threads.
+    void Push(const T& value) {
+        // The node is taken once and lost races retry with it. An eliminated push hands over
+        // the caller's value and gives the node back to this thread's node cache, so the pair
+        // touches neither the head nor the shared free list.
+        ContentionScope scope(stats_);
+        auto* node = stack_.MakeNode(value);
+        while (!stack_.TryPushNode(node)) {
+            scope.Spin();
+            if (TryEliminatePush(value)) {
+                stack_.ReleaseNode(node);
+                return;
+            }
+        }
+    }
+
+    // Pop removes top element from the stack.
+    //
+    // Safe to call from multiple threads.
+    std::optional<T> Pop() {
+        ContentionScope scope(stats_);
+        std::optional<T> result;
+        while (!stack_.TryPop(result)) {
+            scope.Spin();
+            if (TryEliminatePop(result)) {
+                break;
+            }
+        }
+        return result;
+    }
+
+    // Every Push and Pop counts as an acquisition and every lost race for the head as a spin,
+    // whether or not the operation was then eliminated. GetStackContentionStats() reports the
+    // single head attempts of the underlying MPSCStack.
+    ContentionSnapshot GetContentionStats() const {
+        return stats_.Snapshot();
+    }
+
+    ContentionSnapshot GetStackContentionStats() const {
+        return stack_.GetContentionStats();
+    }
+
+private:
+    // A waiting operation lives on the waiter's stack. The slot stores its address with the
+    // low bit set for pops; whoever clears the slot with a CAS owns the exchange and must set
+    // done, and the waiter does not return before done is set.
+    struct Exchange {
+        const T* push_value = nullptr;
+        std::optional<T>* pop_result = nullptr;
+        std::atomic<bool> done{false};
+    };
+
+    struct alignas(64) Slot {
+        std::atomic<uintptr_t> waiter{0};
+    };
+
+    static constexpr uintptr_t kPopBit = 1;
+    static constexpr int kWaitSpins = 256;
+
+    bool TryEliminatePush(const T& value) {
+        Slot& slot = RandomSlot();
+        uintptr_t seen = slot.waiter.load();
+        if (seen & kPopBit) {
+            if (slot.waiter.compare_exchange_strong(seen, 0)) {
+                Exchange* pop = reinterpret_cast<Exchange*>(seen & ~kPopBit);
+                pop->pop_result->emplace(value);
+                pop->done.store(true);
+                return true;
+            }
+            Grow();
+            return false;
+        }
+        Exchange push;
+        push.push_value = &value;
+        return Wait(slot, seen, reinterpret_cast<uintptr_t>(&push), push);
+    }
+
+    bool TryEliminatePop(std::optional<T>& result) {
+        Slot& slot = RandomSlot();
+        uintptr_t seen = slot.waiter.load();
+        if (seen && !(seen & kPopBit)) {
+            if (slot.waiter.compare_exchange_strong(seen, 0)) {
+                Exchange* push = reinterpret_cast<Exchange*>(seen);
+                result.emplace(*push->push_value);
+                push->done.store(true);
+                return true;
+            }
+            Grow();
+            return false;
+        }
+        Exchange pop;
+        pop.pop_result = &result;
+        return Wait(slot, seen, reinterpret_cast<uintptr_t>(&pop) | kPopBit, pop);
+    }
+
+    // Wait parks our own exchange in an empty slot and spins for a partner.
+    bool Wait(Slot& slot, uintptr_t seen, uintptr_t mine, Exchange& exchange) {
+        if (seen || !slot.waiter.compare_exchange_strong(seen, mine)) {
+            Grow();
+            return false;
+        }
+        for (int i = 0; i < kWaitSpins; ++i) {
+            if (exchange.done.load()) {
+                return true;
+            }
+        }
+        if (slot.waiter.compare_exchange_strong(mine, 0)) {
+            Shrink();
+            return false;
+        }
+        // A partner has claimed the exchange and is finishing it.
+        while (!exchange.done.load()) {
+        }
+        return true;
+    }
+
+    Slot& RandomSlot() {
+        return slots_[ThreadLocalRandom() % range_.load(std::memory_order_relaxed)];
+    }
+
+    void Grow() {
+        size_t range = range_.load(std::memory_order_relaxed);
+        if (range < slots_.size()) {
+            range_.compare_exchange_weak(range, range + 1, std::memory_order_relaxed);
+        }
+    }
+
+    void Shrink() {
+        size_t range = range_.load(std::memory_order_relaxed);
+        if (range > 1) {
+            range_.compare_exchange_weak(range, range - 1, std::memory_order_relaxed);
+        }
+    }
+
+    MPSCStack<T> stack_;
+    std::vector<Slot> slots_;
+    std::atomic<size_t> range_{1};
+    [[no_unique_address]] ContentionStats stats_;
+};
@@ -1,70 +1,287 @@
 #pragma once
 
 #include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
 #include <optional>
 #include <stdexcept>
 #include <utility>
+#include <vector>
+
+#include "../counter/sharded_counter.h"
+#include "../instrumentation/contention.h"
+
+// Order in which DequeueAll() hands the elements to the callback.
+enum class DequeueOrder {
+    kLifo,  // Most recently pushed first, like repeated Pop().
+    kFifo,  // Oldest first.
+};
 
 template <class T>
 class MPSCStack {
 public:
+    MPSCStack() = default;
+    MPSCStack(const MPSCStack&) = delete;
+    MPSCStack& operator=(const MPSCStack&) = delete;
+
     // Push adds one element to stack top.
     //
     // Safe to call from multiple threads.
     void Push(const T& value) {
-        Node* old_head = head_.load();
-        Node* new_head = new Node{value, old_head};
-        do {
-            new_head->next = old_head;
-        } while (!head_.compare_exchange_weak(old_head, new_head));
+        Node* node = MakeNode(value);
+        PushChain(head_, node, node, stats_);
+    }
+
+    // TryPush makes a single attempt to push and returns false if it lost a race for the head.
+    //
+    // Lets callers such as EliminationStack back off instead of spinning on head_.
+    bool TryPush(const T& value) {
+        Node* node = MakeNode(value);
+        if (TryPushNode(node)) {
+            return true;
+        }
+        ReleaseNode(node);
+        return false;
     }
 
     // Pop removes top element from the stack.
     //
-    // Not safe to call concurrently.
+    // Safe to call from multiple threads: the head is a tagged pointer and nodes are never
+    // returned to the allocator while the stack is alive, so a stale head can't be reused.
     std::optional<T> Pop() {
-        Node* old_head = head_.load();
-        Node* new_head;
-        do {
-            if (!old_head) {
-                return std::nullopt;
-            }
-            new_head = old_head->next;
-        } while (!head_.compare_exchange_weak(old_head, new_head));
-        T ans = std::move(old_head->value);
-        delete old_head;
-        return ans;
+        Node* node = PopNode(head_, stats_);
+        if (!node) {
+            return std::nullopt;
+        }
+        return TakeValue(node);
+    }
+
+    // TryPop makes a single attempt to pop and returns false if it lost a race for the head.
+    // Otherwise result holds the popped element, or nullopt if the stack was empty.
+    bool TryPop(std::optional<T>& result) {
+        ContentionScope scope(stats_);
+        TaggedPtr old_head = head_.load();
+        Node* node = GetNode(old_head);
+        if (!node) {
+            result.reset();
+            return true;
+        }
+        if (!head_.compare_exchange_strong(old_head, NextTag(old_head, node->next.load()))) {
+            scope.Spin();
+            return false;
+        }
+        result = TakeValue(node);
+        return true;
     }
 
-    // DequeuedAll Pop's all elements from the stack and calls cb() for each.
+    // DequeuedAll detaches the whole stack at once and calls cb() for each element.
     //
-    // Not safe to call concurrently with Pop()
+    // Safe to call concurrently with Push() and Pop().
     template <class TFn>
-    void DequeueAll(const TFn& cb) {
-        std::optional<T> elem = Pop();
-        while (elem.has_value()) {
-            cb(elem.value());
-            elem = Pop();
+    void DequeueAll(const TFn& cb, DequeueOrder order = DequeueOrder::kLifo) {
+        Node* first = Snatch(head_, stats_);
+        if (!first) {
+            return;
+        }
+        if (order == DequeueOrder::kFifo) {
+            first = Reverse(first);
+        }
+        Node* last = first;
+        for (Node* node = first; node; node = node->next.load()) {
+            cb(*node->Value());
+            node->Value()->~T();
+            last = node;
         }
+        PushChain(free_nodes_, first, last, pool_stats_);
     }
 
     ~MPSCStack() {
-        std::optional<T> elem = Pop();
-        while (elem.has_value()) {
-            elem = Pop();
+        for (Node* node = Snatch(head_, stats_); node; node = node->next.load()) {
+            node->Value()->~T();
         }
     }
 
+    // Node API for layers built on top of the stack, such as EliminationStack, that keep one
+    // node across several push attempts.
+    struct Node;
+
+    // MakeNode takes a node from the pool and copies value into it.
+    Node* MakeNode(const T& value) {
+        Node* node = AcquireNode();
+        try {
+            new (node->Value()) T(value);
+        } catch (...) {
+            RecycleNode(node);
+            throw;
+        }
+        return node;
+    }
+
+    // TryPushNode makes a single attempt to link a node from MakeNode() on top of the stack.
+    bool TryPushNode(Node* node) {
+        ContentionScope scope(stats_);
+        TaggedPtr old_head = head_.load();
+        node->next.store(GetNode(old_head));
+        if (!head_.compare_exchange_strong(old_head, NextTag(old_head, node))) {
+            scope.Spin();
+            return false;
+        }
+        return true;
+    }
+
+    // ReleaseNode destroys the value of a node that was never pushed and returns it to the pool.
+    void ReleaseNode(Node* node) {
+        node->Value()->~T();
+        RecycleNode(node);
+    }
+
+    // Every operation on the head, or single attempt of TryPush/TryPop, counts as an
+    // acquisition and every lost CAS as a spin.
+    ContentionSnapshot GetContentionStats() const {
+        return stats_.Snapshot();
+    }
+
+    // The same for the shared free list of the node pool, which the per-thread spare nodes
+    // keep out of the way.
+    ContentionSnapshot GetPoolContentionStats() const {
+        return pool_stats_.Snapshot();
+    }
+
 private:
-    struct Node {
-        T value;
-        Node* next;
-    };
+    // A head word packs the node pointer into the low kPointerBits bits and a modification
+    // counter into the rest, so that a Pop() which read a stale head fails its CAS even if the
+    // same node is back on top (ABA). User space pointers fit into 48 bits on x86-64 and
+    // AArch64.
+    using TaggedPtr = uint64_t;
+    static_assert(sizeof(void*) == sizeof(TaggedPtr), "tagged pointers need a 64-bit platform");
+
+    static constexpr int kPointerBits = 48;
+    static constexpr TaggedPtr kPointerMask = (TaggedPtr{1} << kPointerBits) - 1;
+    static constexpr TaggedPtr kTagUnit = TaggedPtr{1} << kPointerBits;
+    static constexpr size_t kChunkSize = 64;
 
-    struct ConcurrentNode {
-        uint32_t counter;
-        Node* inside_node;
+    // Every thread keeps at most one spare node in its own cache line, so a thread that frees
+    // a node and then needs one again doesn't go through the shared free_nodes_ head.
+    struct alignas(64) NodeCache {
+        std::atomic<Node*> node{nullptr};
     };
 
-    std::atomic<Node*> head_{nullptr};
+    static Node* GetNode(TaggedPtr tagged) {
+        return reinterpret_cast<Node*>(tagged & kPointerMask);
+    }
+
+    static TaggedPtr NextTag(TaggedPtr tagged, Node* node) {
+        return ((tagged & ~kPointerMask) + kTagUnit) | reinterpret_cast<TaggedPtr>(node);
+    }
+
+    // PushChain links an already connected first..last chain on top of head with one CAS.
+    static void PushChain(std::atomic<TaggedPtr>& head, Node* first, Node* last,
+                          ContentionStats& stats) {
+        ContentionScope scope(stats);
+        TaggedPtr old_head = head.load();
+        last->next.store(GetNode(old_head));
+        while (!head.compare_exchange_weak(old_head, NextTag(old_head, first))) {
+            scope.Spin();
+            last->next.store(GetNode(old_head));
+        }
+    }
+
+    static Node* PopNode(std::atomic<TaggedPtr>& head, ContentionStats& stats) {
+        ContentionScope scope(stats);
+        TaggedPtr old_head = head.load();
+        while (Node* node = GetNode(old_head)) {
+            // node may already be popped and reused by now: the value read here is then
+            // garbage, but the tag makes the CAS below fail.
+            Node* next = node->next.load();
+            if (head.compare_exchange_weak(old_head, NextTag(old_head, next))) {
+                return node;
+            }
+            scope.Spin();
+        }
+        return nullptr;
+    }
+
+    // Snatch detaches the whole list. A plain exchange can't advance the tag, so this is a
+    // single CAS that only retries when the head changes under it.
+    static Node* Snatch(std::atomic<TaggedPtr>& head, ContentionStats& stats) {
+        ContentionScope scope(stats);
+        TaggedPtr old_head = head.load();
+        while (GetNode(old_head) &&
+               !head.compare_exchange_weak(old_head, NextTag(old_head, nullptr))) {
+            scope.Spin();
+        }
+        return GetNode(old_head);
+    }
+
+    static Node* Reverse(Node* node) {
+        Node* reversed = nullptr;
+        while (node) {
+            Node* next = node->next.load();
+            node->next.store(reversed);
+            reversed = node;
+            node = next;
+        }
+        return reversed;
+    }
+
+    std::optional<T> TakeValue(Node* node) {
+        std::optional<T> ans(std::move(*node->Value()));
+        node->Value()->~T();
+        RecycleNode(node);
+        return ans;
+    }
+
+    NodeCache& LocalCache() {
+        return node_caches_[CounterHomeShard() & (node_caches_.size() - 1)];
+    }
+
+    // RecycleNode returns a node without a value to the pool.
+    void RecycleNode(Node* node) {
+        Node* empty = nullptr;
+        if (!LocalCache().node.compare_exchange_strong(empty, node)) {
+            PushChain(free_nodes_, node, node, pool_stats_);
+        }
+    }
+
+    Node* AcquireNode() {
+        if (Node* node = LocalCache().node.exchange(nullptr)) {
+            return node;
+        }
+        if (Node* node = PopNode(free_nodes_, pool_stats_)) {
+            return node;
+        }
+        std::unique_ptr<Node[]> chunk(new Node[kChunkSize]);
+        for (size_t i = 2; i < kChunkSize; ++i) {
+            chunk[i - 1].next.store(&chunk[i]);
+        }
+        Node* node = &chunk[0];
+        Node* rest = &chunk[1];
+        Node* rest_last = &chunk[kChunkSize - 1];
+        {
+            std::lock_guard lock(chunks_mutex_);
+            chunks_.push_back(std::move(chunk));
+        }
+        PushChain(free_nodes_, rest, rest_last, pool_stats_);
+        return node;
+    }
+
+    std::atomic<TaggedPtr> head_{0};
+    std::atomic<TaggedPtr> free_nodes_{0};
+    std::vector<NodeCache> node_caches_ = std::vector<NodeCache>(DefaultCounterShardsCount());
+    std::mutex chunks_mutex_;
+    std::vector<std::unique_ptr<Node[]>> chunks_;
+    [[no_unique_address]] ContentionStats stats_;
+    [[no_unique_address]] ContentionStats pool_stats_;
+};
+
+template <class T>
+struct MPSCStack<T>::Node {
+    T* Value() {
+        return std::launder(reinterpret_cast<T*>(storage));
+    }
+
+    alignas(T) unsigned char storage[sizeof(T)];
+    std::atomic<Node*> next{nullptr};
 };
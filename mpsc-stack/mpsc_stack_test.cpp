@@ -0,0 +1,94 @@
+// Correctness checks for the tagged-pointer MPSCStack and for EliminationStack on top of it:
+// under concurrent pushes and pops every pushed value must come out exactly once.
+
+#include "mpsc_stack.h"
+#include "elimination_stack.h"
+#include "../test/check.h"
+
+#include <atomic>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr int kThreads = 8;
+constexpr int kPerThread = 50'000;
+
+// Every thread pushes its own range of values and pops after each odd push, so the head is
+// contended by both operations and nodes are recycled through the pool while in use by others.
+template <class Stack, class TDrain>
+void TestConservation(const TDrain& drain) {
+    Stack stack;
+    std::vector<std::vector<int>> popped(kThreads);
+    std::atomic<bool> start{false};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&stack, &popped, &start, t] {
+            while (!start.load()) {
+            }
+            for (int i = 0; i < kPerThread; ++i) {
+                stack.Push(t * kPerThread + i);
+                if (i % 2 == 1) {
+                    if (std::optional<int> value = stack.Pop()) {
+                        popped[t].push_back(*value);
+                    }
+                }
+            }
+        });
+    }
+    start.store(true);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<int> seen(kThreads * kPerThread, 0);
+    for (const auto& values : popped) {
+        for (int value : values) {
+            CHECK(value >= 0 && value < kThreads * kPerThread);
+            ++seen[value];
+        }
+    }
+    drain(stack, [&seen](int value) {
+        CHECK(value >= 0 && value < kThreads * kPerThread);
+        ++seen[value];
+    });
+    for (int count : seen) {
+        CHECK(count == 1);
+    }
+    CHECK(!stack.Pop().has_value());
+}
+
+void TestDequeueAllOrder() {
+    MPSCStack<int> stack;
+    for (int i = 0; i < 100; ++i) {
+        stack.Push(i);
+    }
+    int expected = 0;
+    stack.DequeueAll([&expected](int value) { CHECK(value == expected++); }, DequeueOrder::kFifo);
+    CHECK(expected == 100);
+    CHECK(!stack.Pop().has_value());
+
+    // Nodes freed by DequeueAll are reused by later pushes.
+    for (int i = 0; i < 100; ++i) {
+        stack.Push(i);
+    }
+    expected = 99;
+    stack.DequeueAll([&expected](int value) { CHECK(value == expected--); });
+    CHECK(expected == -1);
+}
+
+}  // namespace
+
+int main() {
+    TestConservation<MPSCStack<int>>([](MPSCStack<int>& stack, const auto& cb) {
+        stack.DequeueAll(cb);
+    });
+    TestConservation<EliminationStack<int>>([](EliminationStack<int>& stack, const auto& cb) {
+        while (std::optional<int> value = stack.Pop()) {
+            cb(*value);
+        }
+    });
+    TestDequeueAllOrder();
+    return 0;
+}
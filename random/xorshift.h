@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+// ThreadLocalRandom returns the next value of a per-thread xorshift64 generator.
+//
+// It is meant for cheap randomized choices on hot paths (victims, slots, levels), not for
+// anything that needs statistical quality. The state is seeded from the thread id and never
+// becomes zero.
+inline uint64_t ThreadLocalRandom() {
+    thread_local uint64_t state = std::hash<std::thread::id>()(std::this_thread::get_id()) | 1;
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
@@ -2,12 +2,16 @@
 
 #include <atomic>
 
+#include "../instrumentation/contention.h"
+
 struct RWSpinLock {
     void LockRead() {
+        ContentionScope scope(stats);
         int expected = atomic.load();
         expected = expected - expected % 2;
         while (!atomic.compare_exchange_weak(expected, expected + 2)) {
             expected = expected - expected % 2;
+            scope.Spin();
         }
     }
 
@@ -16,14 +20,22 @@ struct RWSpinLock {
     }
 
     void LockWrite() {
+        ContentionScope scope(stats);
         int expected = 0;
         while (!atomic.compare_exchange_weak(expected, 1)) {
             expected = 0;
+            scope.Spin();
         };
     }
 
     void UnlockWrite() {
         atomic.store(0);
     }
+
+    ContentionSnapshot GetContentionStats() const {
+        return stats.Snapshot();
+    }
+
     std::atomic<int> atomic = 0;
+    [[no_unique_address]] ContentionStats stats;
 };
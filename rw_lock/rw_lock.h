@@ -2,17 +2,22 @@
 #include <mutex>
 #include <semaphore>
 
+#include "../instrumentation/contention.h"
+
 class RWLock {
 
 public:
     template <class Func>
     void Read(Func func) {
-        read_.acquire();
-        ++blocked_readers_;
-        if (blocked_readers_ == 1) {
-            global_.acquire();
+        {
+            ContentionScope scope(stats_);
+            AcquireCounted(read_, scope);
+            ++blocked_readers_;
+            if (blocked_readers_ == 1) {
+                AcquireCounted(global_, scope);
+            }
+            read_.release();
         }
-        read_.release();
         try {
             func();
         } catch (...) {
@@ -24,7 +29,10 @@ public:
 
     template <class Func>
     void Write(Func func) {
-        global_.acquire();
+        {
+            ContentionScope scope(stats_);
+            AcquireCounted(global_, scope);
+        }
         try {
             func();
         } catch (...) {
@@ -34,10 +42,15 @@ public:
         global_.release();
     }
 
+    ContentionSnapshot GetContentionStats() const {
+        return stats_.Snapshot();
+    }
+
 private:
     std::binary_semaphore read_{1};
     std::binary_semaphore global_{1};
     int blocked_readers_ = 0;
+    [[no_unique_address]] ContentionStats stats_;
 
     void EndRead() {
         read_.acquire();
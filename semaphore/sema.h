@@ -4,6 +4,8 @@
 #include <vector>
 #include <condition_variable>
 
+#include "../instrumentation/contention.h"
+
 using namespace std::chrono_literals;
 
 class DefaultCallback {
@@ -26,10 +28,13 @@ public:
 
     template <class Func>
     void Enter(Func callback) {
-        std::unique_lock<std::mutex> lock(mutex_);
+        ContentionScope scope(stats_);
+        std::unique_lock<std::mutex> lock = LockCounted(mutex_, scope);
         ++waiting_count_;
         int my_position = waiting_count_;
         while (!count_ && my_position != 1) {
+            // Every polling round counts as a spin.
+            scope.Spin();
             cv_.wait_for(lock, 10ms);
         }
         --waiting_count_;
@@ -41,9 +46,14 @@ public:
         Enter(callback);
     }
 
+    ContentionSnapshot GetContentionStats() const {
+        return stats_.Snapshot();
+    }
+
 private:
     std::mutex mutex_;
     std::condition_variable cv_;
     int count_ = 0;
     int waiting_count_ = 0;
+    [[no_unique_address]] ContentionStats stats_;
 };
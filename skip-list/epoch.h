@@ -0,0 +1,158 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Epoch-based reclamation for data structures whose readers walk through many nodes without
+// validating them (a hazard pointer per node would be needed otherwise).
+//
+// Readers run inside an EpochGuard. A retired object goes to the retiring thread's limbo list
+// for the current global epoch, and the global epoch only advances once every active thread
+// has observed it; objects retired two epochs ago can then no longer be reached and are freed.
+// Thread records are never freed: a record released at thread exit is reused, together with
+// its pending limbo lists, by the next thread.
+class EpochReclaimer {
+public:
+    static EpochReclaimer& Instance() {
+        static EpochReclaimer* reclaimer = new EpochReclaimer();
+        return *reclaimer;
+    }
+
+    void Enter() {
+        ThreadRecord& record = LocalRecord();
+        if (record.depth++ == 0) {
+            record.active.store(true);
+            record.epoch.store(global_epoch_.load());
+        }
+    }
+
+    void Exit() {
+        ThreadRecord& record = LocalRecord();
+        if (--record.depth == 0) {
+            record.active.store(false, std::memory_order_release);
+        }
+    }
+
+    template <class T, class Deleter = std::default_delete<T>>
+    void Retire(T* value, Deleter deleter = {}) {
+        ThreadRecord& record = LocalRecord();
+        uint64_t epoch = global_epoch_.load();
+        Limbo& limbo = record.limbo[epoch % kLimboLists];
+        if (limbo.epoch != epoch) {
+            // Whatever is still here is at least three epochs old.
+            FreeAll(limbo);
+            limbo.epoch = epoch;
+        }
+        limbo.retired.push_back([value, deleter]() { deleter(value); });
+        if (++record.retired_since_scan >= kScanThreshold) {
+            record.retired_since_scan = 0;
+            TryAdvance();
+            Collect(record);
+        }
+    }
+
+private:
+    static constexpr uint64_t kLimboLists = 3;
+    static constexpr size_t kScanThreshold = 128;
+
+    struct Limbo {
+        uint64_t epoch = 0;
+        std::vector<std::function<void()>> retired;
+    };
+
+    struct alignas(64) ThreadRecord {
+        std::atomic<uint64_t> epoch{0};
+        std::atomic<bool> active{false};
+        std::atomic<bool> in_use{true};
+        ThreadRecord* next = nullptr;
+        // Owned by the thread that holds the record.
+        size_t depth = 0;
+        size_t retired_since_scan = 0;
+        std::array<Limbo, kLimboLists> limbo;
+    };
+
+    class RecordHolder {
+    public:
+        explicit RecordHolder(ThreadRecord* record) : record_(record) {
+        }
+
+        ~RecordHolder() {
+            record_->active.store(false);
+            record_->in_use.store(false);
+        }
+
+        ThreadRecord* Get() const {
+            return record_;
+        }
+
+    private:
+        ThreadRecord* record_;
+    };
+
+    ThreadRecord& LocalRecord() {
+        thread_local RecordHolder holder(AcquireRecord());
+        return *holder.Get();
+    }
+
+    ThreadRecord* AcquireRecord() {
+        for (ThreadRecord* record = records_.load(); record; record = record->next) {
+            bool in_use = false;
+            if (!record->in_use.load() && record->in_use.compare_exchange_strong(in_use, true)) {
+                return record;
+            }
+        }
+        ThreadRecord* record = new ThreadRecord();
+        record->next = records_.load();
+        while (!records_.compare_exchange_weak(record->next, record)) {
+        }
+        return record;
+    }
+
+    void TryAdvance() {
+        uint64_t epoch = global_epoch_.load();
+        for (ThreadRecord* record = records_.load(); record; record = record->next) {
+            if (record->active.load() && record->epoch.load() != epoch) {
+                return;
+            }
+        }
+        global_epoch_.compare_exchange_strong(epoch, epoch + 1);
+    }
+
+    void Collect(ThreadRecord& record) {
+        uint64_t epoch = global_epoch_.load();
+        for (Limbo& limbo : record.limbo) {
+            if (limbo.epoch + 2 <= epoch) {
+                FreeAll(limbo);
+            }
+        }
+    }
+
+    static void FreeAll(Limbo& limbo) {
+        for (auto& deleter : limbo.retired) {
+            deleter();
+        }
+        limbo.retired.clear();
+    }
+
+    std::atomic<uint64_t> global_epoch_{kLimboLists};
+    std::atomic<ThreadRecord*> records_{nullptr};
+};
+
+// EpochGuard marks the calling thread as reading shared nodes for its lifetime.
+class EpochGuard {
+public:
+    EpochGuard() {
+        EpochReclaimer::Instance().Enter();
+    }
+
+    ~EpochGuard() {
+        EpochReclaimer::Instance().Exit();
+    }
+
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+};
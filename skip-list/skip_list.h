@@ -0,0 +1,257 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+
+#include "epoch.h"
+#include "../instrumentation/contention.h"
+#include "../random/xorshift.h"
+
+// Ordered concurrent map: the lazy skip list of Herlihy, Lev, Luchangco and Shavit.
+//
+// Find and range scans take no locks at all. Insert and Erase lock only the predecessors of
+// the affected node and validate them before linking; a node is logically removed by marking
+// it and then unlinked from the top level down. Unlinked nodes are freed through
+// EpochReclaimer once no reader can still be walking over them.
+template <class K, class V, class Compare = std::less<K>>
+class ConcurrentSkipListMap {
+public:
+    explicit ConcurrentSkipListMap(const Compare& comparator = Compare())
+        : comparator_(comparator), head_(Node::Create(kMaxLevel - 1, K(), V())) {
+    }
+
+    ConcurrentSkipListMap(const ConcurrentSkipListMap&) = delete;
+    ConcurrentSkipListMap& operator=(const ConcurrentSkipListMap&) = delete;
+
+    ~ConcurrentSkipListMap() {
+        Node* node = head_;
+        while (node) {
+            Node* next = node->Next(0).load();
+            Node::Destroy(node);
+            node = next;
+        }
+    }
+
+    bool Insert(const K& key, const V& value) {
+        int top_level = RandomLevel();
+        Path preds;
+        Path succs;
+        EpochGuard guard;
+        while (true) {
+            if (int found = FindPath(key, preds, succs); found != kNotFound) {
+                Node* node = succs[found];
+                if (!node->marked.load()) {
+                    while (!node->fully_linked.load()) {
+                    }
+                    return false;
+                }
+                // Being erased right now: retry until it is unlinked.
+                continue;
+            }
+            std::array<std::unique_lock<std::mutex>, kMaxLevel> locks;
+            bool valid = true;
+            for (int level = 0; valid && level <= top_level; ++level) {
+                Node* pred = preds[level];
+                Node* succ = succs[level];
+                if (level == 0 || pred != preds[level - 1]) {
+                    locks[level] = LockNode(pred);
+                }
+                valid = !pred->marked.load() && (!succ || !succ->marked.load()) &&
+                        pred->Next(level).load() == succ;
+            }
+            if (!valid) {
+                continue;
+            }
+            Node* node = Node::Create(top_level, key, value);
+            for (int level = 0; level <= top_level; ++level) {
+                node->Next(level).store(succs[level]);
+            }
+            for (int level = 0; level <= top_level; ++level) {
+                preds[level]->Next(level).store(node);
+            }
+            node->fully_linked.store(true);
+            size_.fetch_add(1);
+            return true;
+        }
+    }
+
+    bool Erase(const K& key) {
+        // The guard is declared first so that it outlives victim_lock: an early return may
+        // still hold the lock of a node that another Erase has already retired.
+        EpochGuard guard;
+        Node* victim = nullptr;
+        std::unique_lock<std::mutex> victim_lock;
+        Path preds;
+        Path succs;
+        while (true) {
+            int found = FindPath(key, preds, succs);
+            if (!victim) {
+                if (found == kNotFound) {
+                    return false;
+                }
+                Node* node = succs[found];
+                if (!node->fully_linked.load() || node->top_level != found ||
+                    node->marked.load()) {
+                    return false;
+                }
+                victim = node;
+                victim_lock = LockNode(victim);
+                if (victim->marked.load()) {
+                    return false;
+                }
+                victim->marked.store(true);
+            }
+            std::array<std::unique_lock<std::mutex>, kMaxLevel> locks;
+            bool valid = true;
+            for (int level = 0; valid && level <= victim->top_level; ++level) {
+                Node* pred = preds[level];
+                if (level == 0 || pred != preds[level - 1]) {
+                    locks[level] = LockNode(pred);
+                }
+                valid = !pred->marked.load() && pred->Next(level).load() == victim;
+            }
+            if (!valid) {
+                continue;
+            }
+            for (int level = victim->top_level; level >= 0; --level) {
+                preds[level]->Next(level).store(victim->Next(level).load());
+            }
+            victim_lock.unlock();
+            size_.fetch_sub(1);
+            EpochReclaimer::Instance().Retire(victim, Node::Destroy);
+            return true;
+        }
+    }
+
+    std::pair<bool, V> Find(const K& key) const {
+        EpochGuard guard;
+        Node* node = LowerBound(key);
+        if (node && !comparator_(key, node->key) && node->fully_linked.load() &&
+            !node->marked.load()) {
+            return std::make_pair(true, node->value);
+        }
+        return std::make_pair(false, V());
+    }
+
+    // Range calls cb(key, value) for every key in [from, to) in ascending order.
+    //
+    // Keys inserted or erased concurrently may or may not be visited.
+    template <class TFn>
+    void Range(const K& from, const K& to, const TFn& cb) const {
+        EpochGuard guard;
+        for (Node* node = LowerBound(from); node && comparator_(node->key, to);
+             node = node->Next(0).load()) {
+            if (node->fully_linked.load() && !node->marked.load()) {
+                cb(node->key, node->value);
+            }
+        }
+    }
+
+    size_t Size() const {
+        return size_.load();
+    }
+
+    // Counts the node locks taken by Insert and Erase; lookups take none.
+    ContentionSnapshot GetContentionStats() const {
+        return stats_.Snapshot();
+    }
+
+private:
+    static constexpr int kMaxLevel = 24;
+    static constexpr int kNotFound = -1;
+
+    // The tower of next pointers is allocated inline right after the node, so a hop during the
+    // search touches one allocation instead of two. The head sentinel holds default key and
+    // value and is never compared.
+    struct Node {
+        static Node* Create(int level, const K& key, const V& value) {
+            void* memory = ::operator new(sizeof(Node) + (level + 1) * sizeof(std::atomic<Node*>),
+                                          std::align_val_t{alignof(Node)});
+            Node* node = new (memory) Node(level, key, value);
+            auto* tower = reinterpret_cast<std::atomic<Node*>*>(node + 1);
+            for (int i = 0; i <= level; ++i) {
+                new (tower + i) std::atomic<Node*>(nullptr);
+            }
+            return node;
+        }
+
+        static void Destroy(Node* node) {
+            node->~Node();
+            ::operator delete(node, std::align_val_t{alignof(Node)});
+        }
+
+        Node(int level, const K& k, const V& v) : key(k), value(v), top_level(level) {
+        }
+
+        std::atomic<Node*>& Next(int level) {
+            return std::launder(reinterpret_cast<std::atomic<Node*>*>(this + 1))[level];
+        }
+
+        K key;
+        V value;
+        const int top_level;
+        std::atomic<bool> marked{false};
+        std::atomic<bool> fully_linked{false};
+        std::mutex mutex;
+    };
+    // sizeof(Node) is a multiple of its alignment, so the tower right after it is aligned too.
+    static_assert(alignof(Node) >= alignof(std::atomic<Node*>));
+
+    using Path = std::array<Node*, kMaxLevel>;
+
+    // FindPath fills the predecessors and successors of key on every level and returns the
+    // highest level where key was found.
+    int FindPath(const K& key, Path& preds, Path& succs) const {
+        int found = kNotFound;
+        Node* pred = head_;
+        for (int level = kMaxLevel - 1; level >= 0; --level) {
+            Node* curr = pred->Next(level).load();
+            while (curr && comparator_(curr->key, key)) {
+                pred = curr;
+                curr = pred->Next(level).load();
+            }
+            if (found == kNotFound && curr && !comparator_(key, curr->key)) {
+                found = level;
+            }
+            preds[level] = pred;
+            succs[level] = curr;
+        }
+        return found;
+    }
+
+    // LowerBound returns the first node whose key is not less than key.
+    Node* LowerBound(const K& key) const {
+        Node* pred = head_;
+        Node* curr = nullptr;
+        for (int level = kMaxLevel - 1; level >= 0; --level) {
+            curr = pred->Next(level).load();
+            while (curr && comparator_(curr->key, key)) {
+                pred = curr;
+                curr = pred->Next(level).load();
+            }
+        }
+        return curr;
+    }
+
+    std::unique_lock<std::mutex> LockNode(Node* node) {
+        ContentionScope scope(stats_);
+        return LockCounted(node->mutex, scope);
+    }
+
+    static int RandomLevel() {
+        // Geometric distribution with p = 1/2.
+        return std::countr_zero(ThreadLocalRandom() | (uint64_t{1} << (kMaxLevel - 1)));
+    }
+
+    Compare comparator_;
+    Node* head_;
+    std::atomic<size_t> size_{0};
+    [[no_unique_address]] ContentionStats stats_;
+};
@@ -0,0 +1,122 @@
+// Compares ConcurrentSkipListMap against std::map under a mutex and, for point operations,
+// against ConcurrentHashMap.
+//
+// Usage: skip_list_bench [max_threads] [ops_per_thread] [table|csv|json]
+
+#include "skip_list.h"
+#include "../bench/bench.h"
+#include "../hash-table/concurrent_hash_map.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint64_t kKeys = 1 << 20;
+constexpr uint64_t kScanWidth = 100;
+
+class LockedMap {
+public:
+    bool Insert(uint64_t key, uint64_t value) {
+        std::lock_guard lock(mutex_);
+        return map_.emplace(key, value).second;
+    }
+
+    bool Erase(uint64_t key) {
+        std::lock_guard lock(mutex_);
+        return map_.erase(key) > 0;
+    }
+
+    std::pair<bool, uint64_t> Find(uint64_t key) const {
+        std::lock_guard lock(mutex_);
+        auto it = map_.find(key);
+        if (it == map_.end()) {
+            return std::make_pair(false, uint64_t{0});
+        }
+        return std::make_pair(true, it->second);
+    }
+
+    template <class TFn>
+    void Range(uint64_t from, uint64_t to, const TFn& cb) const {
+        std::lock_guard lock(mutex_);
+        for (auto it = map_.lower_bound(from); it != map_.end() && it->first < to; ++it) {
+            cb(it->first, it->second);
+        }
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::map<uint64_t, uint64_t> map_;
+};
+
+// Results are accumulated here so that the compiler can't drop lookups whose answer is unused.
+std::atomic<uint64_t> sink{0};
+
+template <class Map>
+void Prefill(Map& map) {
+    for (uint64_t key = 0; key < kKeys; key += 2) {
+        map.Insert(key, key);
+    }
+}
+
+// 90% lookups, 5% inserts, 5% erases over a half-full key space.
+template <class Map>
+BenchResult PointOps(const std::string& name, size_t threads, size_t ops_per_thread) {
+    Map map;
+    Prefill(map);
+    return RunWorkload(name, threads, ops_per_thread, [&map, ops_per_thread](size_t t, uint64_t i) {
+        uint64_t random = Mix(t * ops_per_thread + i);
+        uint64_t key = random % kKeys;
+        uint64_t dice = (random >> 32) % 100;
+        if (dice < 90) {
+            sink.fetch_add(map.Find(key).first, std::memory_order_relaxed);
+        } else if (dice < 95) {
+            map.Insert(key, key);
+        } else {
+            map.Erase(key);
+        }
+    });
+}
+
+template <class Map>
+BenchResult RangeScans(const std::string& name, size_t threads, size_t ops_per_thread) {
+    Map map;
+    Prefill(map);
+    return RunWorkload(name, threads, ops_per_thread, [&map, ops_per_thread](size_t t, uint64_t i) {
+        uint64_t from = Mix(t * ops_per_thread + i) % kKeys;
+        uint64_t sum = 0;
+        map.Range(from, from + kScanWidth, [&sum](uint64_t, uint64_t value) { sum += value; });
+        sink.fetch_add(sum, std::memory_order_relaxed);
+    });
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t max_threads = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 64;
+    size_t ops_per_thread = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1'000'000;
+    ReportFormat format = ReportFormat::kTable;
+    if (argc > 3 && !ParseReportFormat(argv[3], format)) {
+        std::fprintf(stderr, "Usage: %s [max_threads] [ops_per_thread] [table|csv|json]\n",
+                     argv[0]);
+        return 1;
+    }
+    using SkipList = ConcurrentSkipListMap<uint64_t, uint64_t>;
+    using HashMap = ConcurrentHashMap<uint64_t, uint64_t>;
+
+    // A scan visits up to kScanWidth keys, so scans run a tenth of the operations.
+    std::vector<BenchResult> results;
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        results.push_back(PointOps<SkipList>("skip_list_point", threads, ops_per_thread));
+        results.push_back(PointOps<LockedMap>("locked_map_point", threads, ops_per_thread));
+        results.push_back(PointOps<HashMap>("hash_map_point", threads, ops_per_thread));
+        results.push_back(RangeScans<SkipList>("skip_list_scan", threads, ops_per_thread / 10));
+        results.push_back(RangeScans<LockedMap>("locked_map_scan", threads, ops_per_thread / 10));
+    }
+    Report(results, format, stdout);
+    return 0;
+}
@@ -0,0 +1,91 @@
+// Correctness checks for ConcurrentSkipListMap: concurrent inserts and erases must leave exactly
+// the expected keys, and range scans running alongside them must stay sorted.
+
+#include "skip_list.h"
+#include "../test/check.h"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr int kWriters = 4;
+constexpr uint64_t kKeysPerWriter = 20'000;
+
+// Writer t owns the keys equal to t modulo kWriters. It inserts all of them, erases the odd
+// multiples and re-inserts every fourth of those, so the final set is known exactly.
+bool Survives(uint64_t key) {
+    uint64_t index = key / kWriters;
+    return index % 2 == 0 || index % 8 == 1;
+}
+
+void TestConcurrentUpdates() {
+    ConcurrentSkipListMap<uint64_t, uint64_t> map;
+    std::atomic<int> writers_left{kWriters};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kWriters; ++t) {
+        threads.emplace_back([&map, &writers_left, t] {
+            for (uint64_t i = 0; i < kKeysPerWriter; ++i) {
+                uint64_t key = i * kWriters + t;
+                CHECK(map.Insert(key, key * 2));
+                CHECK(!map.Insert(key, 0));
+            }
+            for (uint64_t i = 1; i < kKeysPerWriter; i += 2) {
+                CHECK(map.Erase(i * kWriters + t));
+            }
+            for (uint64_t i = 1; i < kKeysPerWriter; i += 8) {
+                CHECK(map.Insert(i * kWriters + t, (i * kWriters + t) * 2));
+            }
+            writers_left.fetch_sub(1);
+        });
+    }
+    // Scans run concurrently with the writers and only check what must hold at any moment.
+    threads.emplace_back([&map, &writers_left] {
+        while (writers_left.load() > 0) {
+            bool first = true;
+            uint64_t previous = 0;
+            map.Range(0, kKeysPerWriter * kWriters, [&](uint64_t key, uint64_t value) {
+                CHECK(first || key > previous);
+                CHECK(value == key * 2);
+                first = false;
+                previous = key;
+            });
+        }
+    });
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    size_t expected_size = 0;
+    for (uint64_t key = 0; key < kKeysPerWriter * kWriters; ++key) {
+        auto [found, value] = map.Find(key);
+        CHECK(found == Survives(key));
+        CHECK(!found || value == key * 2);
+        expected_size += found;
+    }
+    CHECK(map.Size() == expected_size);
+
+    uint64_t next = 0;
+    size_t scanned = 0;
+    map.Range(100, 1000, [&](uint64_t key, uint64_t) {
+        while (!Survives(next) || next < 100) {
+            ++next;
+        }
+        CHECK(key == next++);
+        ++scanned;
+    });
+    size_t expected_scanned = 0;
+    for (uint64_t key = 100; key < 1000; ++key) {
+        expected_scanned += Survives(key);
+    }
+    CHECK(scanned == expected_scanned);
+}
+
+}  // namespace
+
+int main() {
+    TestConcurrentUpdates();
+    return 0;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+// Chase-Lev work-stealing deque (with the C11 memory orders of Le et al., PPoPP'13).
+//
+// The owner thread pushes and pops at the bottom like a stack; any other thread may steal from
+// the top. The buffer grows without bound; retired buffers are kept until the deque dies,
+// because a concurrent Steal() may still be reading them.
+template <class T>
+class ChaseLevDeque {
+    static_assert(std::is_trivially_copyable_v<T>, "elements are stored in atomics");
+
+public:
+    explicit ChaseLevDeque(size_t capacity = 256) {
+        size_t size = 1;
+        while (size < capacity) {
+            size *= 2;
+        }
+        arrays_.push_back(std::make_unique<Array>(size));
+        array_.store(arrays_.back().get());
+    }
+
+    // Push adds an element to the bottom.
+    //
+    // Only the owner thread may call it.
+    void Push(T item) {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        int64_t top = top_.load(std::memory_order_acquire);
+        Array* array = array_.load(std::memory_order_relaxed);
+        if (bottom - top > static_cast<int64_t>(array->mask)) {
+            array = Grow(array, top, bottom);
+        }
+        array->Put(bottom, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    // Pop removes the most recently pushed element.
+    //
+    // Only the owner thread may call it.
+    std::optional<T> Pop() {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        Array* array = array_.load(std::memory_order_relaxed);
+        bottom_.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = top_.load(std::memory_order_relaxed);
+        if (top > bottom) {
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return std::nullopt;
+        }
+        std::optional<T> item = array->Get(bottom);
+        if (top == bottom) {
+            // Last element: race the thieves for it.
+            if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                              std::memory_order_relaxed)) {
+                item.reset();
+            }
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    // Steal removes the oldest element.
+    //
+    // Safe to call from multiple threads. Returns nullopt if the deque is empty or another
+    // thread won the race for the element.
+    std::optional<T> Steal() {
+        int64_t top = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t bottom = bottom_.load(std::memory_order_acquire);
+        if (top >= bottom) {
+            return std::nullopt;
+        }
+        Array* array = array_.load(std::memory_order_acquire);
+        T item = array->Get(top);
+        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+            return std::nullopt;
+        }
+        return item;
+    }
+
+    // Size is approximate when called concurrently with Steal().
+    size_t Size() const {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        int64_t top = top_.load(std::memory_order_relaxed);
+        return bottom > top ? static_cast<size_t>(bottom - top) : 0;
+    }
+
+private:
+    struct Array {
+        explicit Array(size_t size) : mask(size - 1), buffer(new std::atomic<T>[size]) {
+        }
+
+        T Get(int64_t index) const {
+            return buffer[index & mask].load(std::memory_order_relaxed);
+        }
+
+        void Put(int64_t index, T item) {
+            buffer[index & mask].store(item, std::memory_order_relaxed);
+        }
+
+        const size_t mask;
+        std::unique_ptr<std::atomic<T>[]> buffer;
+    };
+
+    Array* Grow(Array* array, int64_t top, int64_t bottom) {
+        auto grown = std::make_unique<Array>(2 * (array->mask + 1));
+        for (int64_t i = top; i < bottom; ++i) {
+            grown->Put(i, array->Get(i));
+        }
+        arrays_.push_back(std::move(grown));
+        array_.store(arrays_.back().get(), std::memory_order_release);
+        return arrays_.back().get();
+    }
+
+    alignas(64) std::atomic<int64_t> top_{0};
+    alignas(64) std::atomic<int64_t> bottom_{0};
+    std::atomic<Array*> array_{nullptr};
+    // Owned by the owner thread.
+    std::vector<std::unique_ptr<Array>> arrays_;
+};
@@ -0,0 +1,253 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "chase_lev_deque.h"
+#include "../fast-queue/mpmc.h"
+#include "../futex/futex.h"
+#include "../random/xorshift.h"
+#include "../timerqueue/timerqueue.h"
+
+// Work-stealing thread pool.
+//
+// Each worker owns a Chase-Lev deque: tasks submitted from a worker go to its own deque, tasks
+// from outside go to a bounded global injection queue. An idle worker takes from its deque,
+// then the injection queue, then steals from random victims, and finally parks on a futex.
+// Delayed tasks wait in a TimerQueue served by one timer thread.
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+    using Clock = TimerQueue<Task>::Clock;
+    using TimePoint = TimerQueue<Task>::TimePoint;
+    using TimerHandle = TimerQueue<Task>::Handle;
+
+public:
+    explicit ThreadPool(size_t threads_count = std::thread::hardware_concurrency(),
+                        int injection_capacity = 1 << 16)
+        : injection_(injection_capacity) {
+        threads_count = std::max<size_t>(threads_count, 1);
+        for (size_t i = 0; i < threads_count; ++i) {
+            workers_.push_back(std::make_unique<Worker>());
+        }
+        for (size_t i = 0; i < threads_count; ++i) {
+            workers_[i]->thread = std::thread([this, i] { WorkerLoop(i); });
+        }
+        timer_thread_ = std::thread([this] { TimerLoop(); });
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Stops the pool after every submitted task has run. Delayed tasks that are not due yet
+    // are dropped.
+    ~ThreadPool() {
+        timers_.Add(Task(), Clock::now());
+        timer_thread_.join();
+        // Only now: workers must not stop while the timer thread still submits due tasks.
+        stopping_.store(true);
+        Wake(INT_MAX);
+        for (auto& worker : workers_) {
+            worker->thread.join();
+        }
+    }
+
+    // Submit schedules task for execution.
+    //
+    // Safe to call from multiple threads, including from the pool's own tasks.
+    void Submit(Task task) {
+        Task* item = new Task(std::move(task));
+        if (Current().pool == this) {
+            workers_[Current().index]->deque.Push(item);
+        } else {
+            while (!injection_.Enqueue(item)) {
+                std::this_thread::yield();
+            }
+        }
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers_.load() > 0) {
+            Wake(1);
+        }
+    }
+
+    // SubmitAt schedules task to be submitted at the given time point.
+    //
+    // The returned handle can cancel or reschedule it until it is due.
+    TimerHandle SubmitAt(Task task, TimePoint at) {
+        if (!task) {
+            // An empty task is reserved for the destructor's stop sentinel.
+            task = [] {};
+        }
+        return timers_.Add(task, at);
+    }
+
+    template <class Rep, class Period>
+    TimerHandle SubmitAfter(Task task, std::chrono::duration<Rep, Period> delay) {
+        return SubmitAt(std::move(task), Clock::now() + delay);
+    }
+
+    // RunUntil keeps executing pool tasks on a worker thread until pred() holds. On any other
+    // thread it just yields.
+    template <class Pred>
+    void RunUntil(const Pred& pred) {
+        while (!pred()) {
+            Task* task = Current().pool == this ? FindTask(Current().index) : nullptr;
+            if (task) {
+                Run(task);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    bool IsWorkerThread() const {
+        return Current().pool == this;
+    }
+
+    size_t ThreadsCount() const {
+        return workers_.size();
+    }
+
+private:
+    struct alignas(64) Worker {
+        ChaseLevDeque<Task*> deque;
+        std::thread thread;
+    };
+
+    struct CurrentWorker {
+        ThreadPool* pool = nullptr;
+        size_t index = 0;
+    };
+
+    static CurrentWorker& Current() {
+        thread_local CurrentWorker current;
+        return current;
+    }
+
+    void WorkerLoop(size_t index) {
+        Current() = {this, index};
+        while (true) {
+            if (Task* task = FindTask(index)) {
+                Run(task);
+                continue;
+            }
+            int epoch = epoch_.load();
+            sleepers_.fetch_add(1);
+            // Re-check after announcing ourselves: a submitter that missed us has already
+            // published its task.
+            if (Task* task = FindTask(index)) {
+                sleepers_.fetch_sub(1);
+                Run(task);
+                continue;
+            }
+            if (stopping_.load()) {
+                sleepers_.fetch_sub(1);
+                return;
+            }
+            FutexWait(reinterpret_cast<int*>(&epoch_), epoch);
+            sleepers_.fetch_sub(1);
+        }
+    }
+
+    void TimerLoop() {
+        while (true) {
+            Task task = timers_.Pop();
+            // Only the destructor's sentinel is empty; every real task that got due before it
+            // still runs.
+            if (!task) {
+                return;
+            }
+            Submit(std::move(task));
+        }
+    }
+
+    Task* FindTask(size_t index) {
+        if (auto task = workers_[index]->deque.Pop()) {
+            return *task;
+        }
+        Task* task = nullptr;
+        if (injection_.Dequeue(task)) {
+            return task;
+        }
+        for (size_t i = 0; i < workers_.size(); ++i) {
+            size_t victim = ThreadLocalRandom() % workers_.size();
+            if (victim == index) {
+                continue;
+            }
+            if (auto stolen = workers_[victim]->deque.Steal()) {
+                return *stolen;
+            }
+        }
+        return nullptr;
+    }
+
+    static void Run(Task* task) {
+        std::unique_ptr<Task> owner(task);
+        (*owner)();
+    }
+
+    void Wake(int count) {
+        epoch_.fetch_add(1);
+        FutexWake(reinterpret_cast<int*>(&epoch_), count);
+    }
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    MPMCBoundedQueue<Task*> injection_;
+    TimerQueue<Task> timers_;
+    std::thread timer_thread_;
+
+    std::atomic<bool> stopping_{false};
+    std::atomic<int> sleepers_{0};
+    // Futex word: bumped on every wakeup so a worker that read the old value doesn't sleep.
+    std::atomic<int> epoch_{0};
+};
+
+// TaskGroup spawns tasks on a pool and waits for all of them (fork-join).
+//
+// Waiting on a worker thread keeps running other pool tasks, so nested groups don't deadlock.
+class TaskGroup {
+public:
+    explicit TaskGroup(ThreadPool& pool) : pool_(pool) {
+    }
+
+    ~TaskGroup() {
+        Wait();
+    }
+
+    void Spawn(ThreadPool::Task task) {
+        pending_.fetch_add(1);
+        pool_.Submit([this, task = std::move(task)] {
+            task();
+            // Once pending_ drops to zero the waiter may return and destroy the group, so
+            // nothing may touch this afterwards. Waking the stale address is a plain syscall;
+            // if another futex word lives there now, its waiters see a spurious wakeup and
+            // re-check.
+            int* word = reinterpret_cast<int*>(&pending_);
+            if (pending_.fetch_sub(1) == 1) {
+                FutexWake(word, INT_MAX);
+            }
+        });
+    }
+
+    void Wait() {
+        if (pool_.IsWorkerThread()) {
+            pool_.RunUntil([this] { return pending_.load() == 0; });
+            return;
+        }
+        for (int pending = pending_.load(); pending != 0; pending = pending_.load()) {
+            FutexWait(reinterpret_cast<int*>(&pending_), pending);
+        }
+    }
+
+private:
+    ThreadPool& pool_;
+    std::atomic<int> pending_{0};
+};
@@ -0,0 +1,121 @@
+// Fork-join and task-throughput benchmarks for the work-stealing ThreadPool.
+//
+// Every workload runs on one driving thread of the shared harness, while the pool size varies;
+// operations are tasks, so Mops/s reads as millions of tasks per second.
+//
+// Usage: thread_pool_bench [max_threads] [table|csv|json]
+
+#include "thread_pool.h"
+#include "../bench/bench.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr int kFibN = 36;
+constexpr int kFibCutoff = 20;
+constexpr uint64_t kTasks = 1'000'000;
+
+int64_t SerialFib(int n) {
+    return n < 2 ? n : SerialFib(n - 1) + SerialFib(n - 2);
+}
+
+// Every call above the cutoff forks one branch as a task and runs the other inline.
+int64_t Fib(ThreadPool& pool, int n) {
+    if (n < kFibCutoff) {
+        return SerialFib(n);
+    }
+    int64_t left = 0;
+    TaskGroup group(pool);
+    group.Spawn([&pool, &left, n] { left = Fib(pool, n - 1); });
+    int64_t right = Fib(pool, n - 2);
+    group.Wait();
+    return left + right;
+}
+
+// FibTasks is the number of tasks Fib(n) spawns.
+uint64_t FibTasks(int n) {
+    return n < kFibCutoff ? 0 : 1 + FibTasks(n - 1) + FibTasks(n - 2);
+}
+
+// Recount reports a single-operation run as the given number of tasks.
+BenchResult Recount(BenchResult result, uint64_t tasks) {
+    result.ops = tasks;
+    result.mops_per_second = static_cast<double>(tasks) / result.seconds / 1e6;
+    return result;
+}
+
+BenchResult ForkJoin(size_t threads) {
+    ThreadPool pool(threads);
+    int64_t result = 0;
+    BenchResult bench = RunWorkload("fork_join", 1, 1, [&pool, &result](size_t, uint64_t) {
+        TaskGroup root(pool);
+        root.Spawn([&pool, &result] { result = Fib(pool, kFibN); });
+        root.Wait();
+    });
+    if (result != SerialFib(kFibN)) {
+        std::fprintf(stderr, "fork_join: wrong fib(%d) = %lld\n", kFibN,
+                     static_cast<long long>(result));
+        std::exit(1);
+    }
+    bench.threads = threads;
+    return Recount(bench, FibTasks(kFibN) + 1);
+}
+
+// Submits many empty tasks from outside the pool; the last operation also waits for them.
+BenchResult External(size_t threads) {
+    ThreadPool pool(threads);
+    std::atomic<uint64_t> done{0};
+    TaskGroup group(pool);
+    BenchResult bench =
+        RunWorkload("submit_external", 1, kTasks, [&group, &done](size_t, uint64_t i) {
+            group.Spawn([&done] { done.fetch_add(1, std::memory_order_relaxed); });
+            if (i + 1 == kTasks) {
+                group.Wait();
+            }
+        });
+    bench.threads = threads;
+    return bench;
+}
+
+// Fans the same number of tasks out from inside the pool.
+BenchResult Internal(size_t threads) {
+    ThreadPool pool(threads);
+    std::atomic<uint64_t> done{0};
+    BenchResult bench = RunWorkload("submit_internal", 1, 1, [&pool, &done](size_t, uint64_t) {
+        TaskGroup root(pool);
+        root.Spawn([&pool, &done] {
+            TaskGroup group(pool);
+            for (uint64_t i = 0; i < kTasks; ++i) {
+                group.Spawn([&done] { done.fetch_add(1, std::memory_order_relaxed); });
+            }
+        });
+        root.Wait();
+    });
+    bench.threads = threads;
+    return Recount(bench, kTasks + 1);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t max_threads = argc > 1 ? std::strtoull(argv[1], nullptr, 10)
+                                  : std::max(1u, std::thread::hardware_concurrency());
+    ReportFormat format = ReportFormat::kTable;
+    if (argc > 2 && !ParseReportFormat(argv[2], format)) {
+        std::fprintf(stderr, "Usage: %s [max_threads] [table|csv|json]\n", argv[0]);
+        return 1;
+    }
+    // Threads in the report are pool threads; the harness drives every workload from one thread.
+    std::vector<BenchResult> results;
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        results.push_back(ForkJoin(threads));
+        results.push_back(External(threads));
+        results.push_back(Internal(threads));
+    }
+    Report(results, format, stdout);
+    return 0;
+}
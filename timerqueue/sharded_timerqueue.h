@@ -0,0 +1,201 @@
+#pragma once
+
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <vector>
+#include <optional>
+#include <atomic>
+#include <thread>
+#include <limits>
+#include <algorithm>
+#include <cstdint>
+
+#include "../instrumentation/contention.h"
+
+using namespace std::chrono_literals;
+
+// Timer service for many producers and many dispatch threads.
+//
+// Every shard owns its own heap and lock; a thread always adds to and pops from its home shard,
+// so uncontended threads never touch a shared cache line. A dispatcher whose home shard has
+// nothing expired steals expired timers from the other shards, and only parks on the shared
+// condition variable when no shard has anything due.
+template <class T>
+class ShardedTimerQueue {
+public:
+    using Clock = std::chrono::steady_clock;
+    using TimePoint = Clock::time_point;
+
+public:
+    explicit ShardedTimerQueue(size_t shards_count = std::thread::hardware_concurrency())
+        : shards_(std::max<size_t>(shards_count, 1)) {
+    }
+
+    // Add schedules item on the calling thread's home shard.
+    //
+    // Safe to call from multiple threads.
+    void Add(const T& item, TimePoint at) {
+        Shard& shard = shards_[HomeShard()];
+        {
+            std::unique_lock lock = LockShard(shard);
+            shard.heap.emplace_back(at, item);
+            std::push_heap(shard.heap.begin(), shard.heap.end(), Later());
+            shard.earliest.store(Ticks(shard.heap.front().first));
+        }
+        // Pairs with the sleepers_/wake_deadline_ stores in Pop(): either the sleeper sees the
+        // new earliest deadline or we see it sleeping past our timer.
+        if (sleepers_.load() > 0 && Ticks(at) < wake_deadline_.load()) {
+            {
+                ContentionScope scope(park_stats_);
+                std::unique_lock barrier = LockCounted(park_mutex_, scope);
+            }
+            park_var_.notify_one();
+        }
+    }
+
+    // Pop blocks until some timer on any shard expires and returns its item.
+    T Pop() {
+        while (true) {
+            if (auto timer = TryPopTimer(); timer.has_value()) {
+                // Sleepers wait until wake_deadline_. Only when this timer was the one they
+                // were waiting on does the next deadline become unwatched, so only then hand
+                // it over, like TimerQueue::Pop does.
+                if (sleepers_.load() > 0 && Ticks(timer->first) <= wake_deadline_.load()) {
+                    park_var_.notify_one();
+                }
+                return std::move(timer->second);
+            }
+            std::unique_lock<std::mutex> lock;
+            {
+                ContentionScope scope(park_stats_);
+                lock = LockCounted(park_mutex_, scope);
+            }
+            sleepers_.fetch_add(1);
+            int64_t earliest = kEmpty;
+            for (const Shard& shard : shards_) {
+                earliest = std::min(earliest, shard.earliest.load());
+            }
+            wake_deadline_.store(earliest);
+            // Re-scan after publishing the deadline, so that a concurrent Add() either notices
+            // it has to wake us or has its timer seen here.
+            earliest = kEmpty;
+            for (const Shard& shard : shards_) {
+                earliest = std::min(earliest, shard.earliest.load());
+            }
+            if (earliest > Ticks(Clock::now())) {
+                if (earliest == kEmpty) {
+                    park_var_.wait(lock);
+                } else {
+                    park_var_.wait_until(lock, TimePoint(Clock::duration(earliest)));
+                }
+            }
+            sleepers_.fetch_sub(1);
+        }
+    }
+
+    // TryPop returns an expired item from the home shard, or steals one from another shard.
+    std::optional<T> TryPop() {
+        if (auto timer = TryPopTimer(); timer.has_value()) {
+            return std::move(timer->second);
+        }
+        return std::nullopt;
+    }
+
+    size_t Size() const {
+        size_t size = 0;
+        for (const Shard& shard : shards_) {
+            std::lock_guard lock(shard.mutex);
+            size += shard.heap.size();
+        }
+        return size;
+    }
+
+    // Aggregates the shard locks taken by Add and by pops from the home shard, and the parking
+    // lock. Steals give up instead of waiting for a busy shard, so they are not counted.
+    ContentionSnapshot GetContentionStats() const {
+        ContentionSnapshot snapshot = park_stats_.Snapshot();
+        for (const Shard& shard : shards_) {
+            snapshot += shard.stats.Snapshot();
+        }
+        return snapshot;
+    }
+
+private:
+    using Pair = std::pair<TimePoint, T>;
+
+    static constexpr int64_t kEmpty = std::numeric_limits<int64_t>::max();
+
+    struct Later {
+        bool operator()(const Pair& lhv, const Pair& rhv) const {
+            return lhv.first > rhv.first;
+        }
+    };
+
+    struct alignas(64) Shard {
+        mutable std::mutex mutex;
+        std::vector<Pair> heap;
+        // Deadline of heap.front(), readable without the lock for stealing and parking.
+        std::atomic<int64_t> earliest{kEmpty};
+        [[no_unique_address]] ContentionStats stats;
+    };
+
+    static int64_t Ticks(TimePoint at) {
+        return at.time_since_epoch().count();
+    }
+
+    static std::unique_lock<std::mutex> LockShard(Shard& shard) {
+        ContentionScope scope(shard.stats);
+        return LockCounted(shard.mutex, scope);
+    }
+
+    // TryPopTimer is TryPop that also returns the deadline of the popped timer.
+    std::optional<Pair> TryPopTimer() {
+        TimePoint now = Clock::now();
+        size_t home = HomeShard();
+        if (auto timer = PopExpired(shards_[home], now, true); timer.has_value()) {
+            return timer;
+        }
+        for (size_t i = 1; i < shards_.size(); ++i) {
+            Shard& victim = shards_[(home + i) % shards_.size()];
+            if (victim.earliest.load() > Ticks(now)) {
+                continue;
+            }
+            if (auto timer = PopExpired(victim, now, false); timer.has_value()) {
+                return timer;
+            }
+        }
+        return std::nullopt;
+    }
+
+    static std::optional<Pair> PopExpired(Shard& shard, TimePoint now, bool is_home) {
+        std::unique_lock<std::mutex> lock;
+        if (is_home) {
+            lock = LockShard(shard);
+        } else if (lock = std::unique_lock(shard.mutex, std::try_to_lock); !lock.owns_lock()) {
+            return std::nullopt;
+        }
+        if (shard.heap.empty() || shard.heap.front().first > now) {
+            return std::nullopt;
+        }
+        std::pop_heap(shard.heap.begin(), shard.heap.end(), Later());
+        std::optional<Pair> timer = std::move(shard.heap.back());
+        shard.heap.pop_back();
+        shard.earliest.store(shard.heap.empty() ? kEmpty : Ticks(shard.heap.front().first));
+        return timer;
+    }
+
+    size_t HomeShard() const {
+        static std::atomic<size_t> next_thread{0};
+        thread_local size_t thread_index = next_thread.fetch_add(1);
+        return thread_index % shards_.size();
+    }
+
+    std::vector<Shard> shards_;
+
+    std::atomic<size_t> sleepers_{0};
+    std::atomic<int64_t> wake_deadline_{kEmpty};
+    std::mutex park_mutex_;
+    std::condition_variable park_var_;
+    [[no_unique_address]] ContentionStats park_stats_;
+};
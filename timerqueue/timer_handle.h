@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+
+// TimerId names one scheduled timer inside a queue. The generation changes every time the
+// underlying slot is reused, so stale ids are detected instead of hitting another timer.
+struct TimerId {
+    uint32_t index = 0;
+    uint32_t generation = 0;
+};
+
+// TimerHandle is returned by Add() of the timer queues and lets the caller cancel or move the
+// timer in O(log n) or better. A default constructed handle refers to no timer.
+//
+// The handle must not outlive the queue that issued it.
+template <class Queue>
+class TimerHandle {
+public:
+    TimerHandle() = default;
+
+    // Cancel removes the timer if it has not been popped yet.
+    //
+    // Returns false if the timer has already been popped or cancelled.
+    bool Cancel() {
+        return queue_ && queue_->Cancel(id_);
+    }
+
+    // Reschedule moves a pending timer to a new time point.
+    //
+    // Returns false if the timer has already been popped or cancelled.
+    bool Reschedule(typename Queue::TimePoint at) {
+        return queue_ && queue_->Reschedule(id_, at);
+    }
+
+private:
+    friend Queue;
+
+    TimerHandle(Queue* queue, TimerId id) : queue_(queue), id_(id) {
+    }
+
+    Queue* queue_ = nullptr;
+    TimerId id_;
+};
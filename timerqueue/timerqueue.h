@@ -3,62 +3,221 @@
 #include <mutex>
 #include <condition_variable>
 #include <chrono>
-#include <map>
-#include <queue>
-#include <iostream>
+#include <vector>
+#include <optional>
+#include <limits>
+#include <cstdint>
+#include <cassert>
+
+#include "timer_handle.h"
+#include "../instrumentation/contention.h"
 
 using namespace std::chrono_literals;
 
 template <class T>
 class TimerQueue {
 public:
-    using Clock = std::chrono::system_clock;
+    using Clock = std::chrono::steady_clock;
     using TimePoint = Clock::time_point;
-    using Pair = std::pair<TimePoint, T>;
+    using Handle = TimerHandle<TimerQueue>;
 
 public:
-    void Add(const T& item, TimePoint at) {
-        // Your code goes here
-        bool needed2notify = false;
-        std::unique_lock lock(mutex_);
-        if (!timepts_.empty()) {
-            Pair top = timepts_.top();
-            if (top.first > at) {
-                needed2notify = true;
-            }
-            timepts_.push({at, item});
-            lock.unlock();
-            if (needed2notify) {
-                var_.notify_all();
-            }
-        } else {
-            timepts_.push({at, item});
-            lock.unlock();
+    // Add schedules item to be returned by Pop() at or after the given time point.
+    //
+    // Wakes one sleeping consumer, and only if the new timer became the earliest one.
+    Handle Add(const T& item, TimePoint at) {
+        std::unique_lock lock = Lock();
+        uint32_t index = AllocateNode(item, at);
+        heap_.push_back(index);
+        nodes_[index].heap_pos = heap_.size() - 1;
+        SiftUp(heap_.size() - 1);
+        bool needed2notify = waiters_ > 0 && heap_.front() == index;
+        Handle handle(this, TimerId{index, nodes_[index].generation});
+        lock.unlock();
+        if (needed2notify) {
+            var_.notify_one();
         }
+        return handle;
     }
 
+    // Pop blocks until the earliest timer expires and returns its item.
+    //
+    // Sleeps exactly until the earliest deadline, or until an earlier timer is added.
     T Pop() {
-        bool time_has_come = false;
-        T ans;
-        while (!time_has_come) {
-            std::unique_lock lock(mutex_);
-            if (!timepts_.empty()) {
-                Pair top = timepts_.top();
-                if (Clock::now() >= top.first) {
-                    time_has_come = true;
-                    ans = top.second;
-                    timepts_.pop();
+        std::unique_lock lock = Lock();
+        while (true) {
+            if (heap_.empty()) {
+                ++waiters_;
+                var_.wait(lock);
+                --waiters_;
+                continue;
+            }
+            TimePoint top = nodes_[heap_.front()].at;
+            if (Clock::now() >= top) {
+                T ans = Extract(heap_.front());
+                // The next deadline is now unwatched: hand it over to another consumer.
+                bool pass_on = waiters_ > 0 && !heap_.empty();
+                lock.unlock();
+                if (pass_on) {
+                    var_.notify_one();
                 }
-                var_.wait_until(lock, top.first);
-            } else {
-                var_.wait_for(lock, 10ms);
+                return ans;
             }
+            ++waiters_;
+            var_.wait_until(lock, top);
+            --waiters_;
         }
-        return ans;
+    }
+
+    // PopAllExpired returns every item whose time has come, earliest first, without blocking.
+    std::vector<T> PopAllExpired() {
+        std::vector<T> expired;
+        std::unique_lock lock = Lock();
+        TimePoint now = Clock::now();
+        while (!heap_.empty() && nodes_[heap_.front()].at <= now) {
+            expired.push_back(Extract(heap_.front()));
+        }
+        return expired;
+    }
+
+    size_t Size() const {
+        std::lock_guard lock(mutex_);
+        return heap_.size();
+    }
+
+    // Counts contention on the queue lock only; waiting for a deadline is not contention.
+    ContentionSnapshot GetContentionStats() const {
+        return stats_.Snapshot();
     }
 
 private:
-    std::priority_queue<Pair, std::vector<Pair>, std::greater<Pair>> timepts_;
+    friend Handle;
+
+    static constexpr uint32_t kNil = std::numeric_limits<uint32_t>::max();
+
+    struct Node {
+        std::optional<T> item;
+        TimePoint at;
+        uint32_t heap_pos = kNil;
+        uint32_t generation = 0;
+    };
+
+    bool Cancel(TimerId id) {
+        std::unique_lock lock = Lock();
+        if (!IsPending(id)) {
+            return false;
+        }
+        Extract(id.index);
+        return true;
+    }
+
+    bool Reschedule(TimerId id, TimePoint at) {
+        std::unique_lock lock = Lock();
+        if (!IsPending(id)) {
+            return false;
+        }
+        Node& node = nodes_[id.index];
+        bool earlier = at < node.at;
+        node.at = at;
+        if (earlier) {
+            SiftUp(node.heap_pos);
+        } else {
+            SiftDown(node.heap_pos);
+        }
+        bool needed2notify = earlier && waiters_ > 0 && heap_.front() == id.index;
+        lock.unlock();
+        if (needed2notify) {
+            var_.notify_one();
+        }
+        return true;
+    }
+
+    std::unique_lock<std::mutex> Lock() {
+        ContentionScope scope(stats_);
+        return LockCounted(mutex_, scope);
+    }
+
+    bool IsPending(TimerId id) const {
+        return id.index < nodes_.size() && nodes_[id.index].heap_pos != kNil &&
+               nodes_[id.index].generation == id.generation;
+    }
+
+    uint32_t AllocateNode(const T& item, TimePoint at) {
+        uint32_t index;
+        if (!free_nodes_.empty()) {
+            index = free_nodes_.back();
+            free_nodes_.pop_back();
+        } else {
+            assert(nodes_.size() < kNil);
+            index = static_cast<uint32_t>(nodes_.size());
+            nodes_.emplace_back();
+        }
+        nodes_[index].item.emplace(item);
+        nodes_[index].at = at;
+        return index;
+    }
+
+    // Extract removes a node from any heap position and returns its item.
+    T Extract(uint32_t index) {
+        Node& node = nodes_[index];
+        size_t pos = node.heap_pos;
+        uint32_t last = heap_.back();
+        heap_.pop_back();
+        if (last != index) {
+            heap_[pos] = last;
+            nodes_[last].heap_pos = pos;
+            SiftUp(pos);
+            SiftDown(nodes_[last].heap_pos);
+        }
+        T ans = std::move(*node.item);
+        node.item.reset();
+        node.heap_pos = kNil;
+        ++node.generation;
+        free_nodes_.push_back(index);
+        return ans;
+    }
+
+    bool Less(size_t lhs, size_t rhs) const {
+        return nodes_[heap_[lhs]].at < nodes_[heap_[rhs]].at;
+    }
+
+    void Swap(size_t lhs, size_t rhs) {
+        std::swap(heap_[lhs], heap_[rhs]);
+        nodes_[heap_[lhs]].heap_pos = lhs;
+        nodes_[heap_[rhs]].heap_pos = rhs;
+    }
+
+    void SiftUp(size_t pos) {
+        while (pos > 0 && Less(pos, (pos - 1) / 2)) {
+            Swap(pos, (pos - 1) / 2);
+            pos = (pos - 1) / 2;
+        }
+    }
+
+    void SiftDown(size_t pos) {
+        while (true) {
+            size_t smallest = pos;
+            size_t left = 2 * pos + 1;
+            size_t right = left + 1;
+            if (left < heap_.size() && Less(left, smallest)) {
+                smallest = left;
+            }
+            if (right < heap_.size() && Less(right, smallest)) {
+                smallest = right;
+            }
+            if (smallest == pos) {
+                return;
+            }
+            Swap(pos, smallest);
+            pos = smallest;
+        }
+    }
+
+    std::vector<Node> nodes_;
+    std::vector<uint32_t> free_nodes_;
+    std::vector<uint32_t> heap_;
+    size_t waiters_ = 0;
     std::condition_variable var_;
-    std::mutex mutex_;
+    mutable std::mutex mutex_;
+    [[no_unique_address]] ContentionStats stats_;
 };
@@ -0,0 +1,94 @@
+// Compares the heap-based TimerQueue against TimingWheel on a request-deadline workload:
+// many pending timers, most of which are cancelled before they fire, and the cost of draining
+// timers that expired while the queue was idle.
+//
+// Usage: timerqueue_bench [max_pending_timers]
+
+#include "timerqueue.h"
+#include "timing_wheel.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr auto kMaxTimeout = 60'000ms;
+// Timeouts of up to kMaxTimeout are compressed into this window for the expire phase.
+constexpr auto kExpireHorizon = 300ms;
+
+template <class Func>
+double NsPerOp(size_t ops, Func func) {
+    auto start = std::chrono::steady_clock::now();
+    func();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / static_cast<double>(ops);
+}
+
+std::vector<std::chrono::milliseconds> MakeTimeouts(size_t count) {
+    std::mt19937_64 gen(count);
+    std::uniform_int_distribution<int> dist(1'000, kMaxTimeout.count());
+    std::vector<std::chrono::milliseconds> timeouts(count);
+    for (auto& timeout : timeouts) {
+        timeout = std::chrono::milliseconds(dist(gen));
+    }
+    return timeouts;
+}
+
+template <class Queue>
+void Run(const char* name, size_t count, const std::vector<std::chrono::milliseconds>& timeouts) {
+    double add_ns;
+    double cancel_ns;
+    {
+        Queue queue;
+        std::vector<typename Queue::Handle> handles(count);
+        auto now = Queue::Clock::now();
+        add_ns = NsPerOp(count, [&] {
+            for (size_t i = 0; i < count; ++i) {
+                handles[i] = queue.Add(static_cast<int>(i), now + timeouts[i]);
+            }
+        });
+        // Request deadlines are mostly cancelled: drop nine out of ten.
+        size_t cancelled = count - count / 10;
+        cancel_ns = NsPerOp(cancelled, [&] {
+            for (size_t i = 0; i < cancelled; ++i) {
+                handles[i].Cancel();
+            }
+        });
+    }
+    double expire_ns;
+    {
+        Queue queue;
+        // Deadlines lie in the future, past the time the adds themselves take, and are spread
+        // over kExpireHorizon; the wheel then has to cascade them down before they expire.
+        auto lead = std::chrono::nanoseconds(static_cast<int64_t>(2 * add_ns * count)) + 10ms;
+        auto base = Queue::Clock::now() + lead;
+        for (size_t i = 0; i < count; ++i) {
+            queue.Add(static_cast<int>(i), base + timeouts[i] * kExpireHorizon.count() / kMaxTimeout.count());
+        }
+        std::this_thread::sleep_until(base + kExpireHorizon + 2ms);
+        size_t expired = 0;
+        expire_ns = NsPerOp(count, [&] { expired = queue.PopAllExpired().size(); });
+        if (expired != count) {
+            std::fprintf(stderr, "%s: %zu of %zu timers expired\n", name, expired, count);
+        }
+    }
+    std::printf("%-8s %10zu %12.1f %12.1f %12.1f\n", name, count, add_ns, cancel_ns, expire_ns);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t max_count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000'000;
+    std::printf("%-8s %10s %12s %12s %12s\n", "queue", "pending", "add ns/op", "cancel ns/op",
+                "expire ns/op");
+    for (size_t count = 10'000; count <= max_count; count *= 10) {
+        auto timeouts = MakeTimeouts(count);
+        Run<TimerQueue<int>>("heap", count, timeouts);
+        Run<TimingWheel<int>>("wheel", count, timeouts);
+    }
+    return 0;
+}
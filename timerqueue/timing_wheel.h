@@ -0,0 +1,327 @@
+#pragma once
+
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <array>
+#include <vector>
+#include <optional>
+#include <bit>
+#include <limits>
+#include <cstdint>
+#include <cassert>
+
+#include "timer_handle.h"
+#include "../instrumentation/contention.h"
+
+using namespace std::chrono_literals;
+
+// Hierarchical timing wheel with the same blocking Add/Pop interface as TimerQueue.
+//
+// Time is cut into ticks of configurable resolution. Level L of the wheel has kSlots slots of
+// kSlots^L ticks each, so Add and Cancel are O(1) list operations and a timer is only moved to a
+// finer level when its coarse slot comes up. Timers never fire early and fire at most one
+// resolution late.
+template <class T>
+class TimingWheel {
+public:
+    using Clock = std::chrono::steady_clock;
+    using TimePoint = Clock::time_point;
+    using Duration = Clock::duration;
+    using Handle = TimerHandle<TimingWheel>;
+
+public:
+    explicit TimingWheel(Duration resolution = 1ms) : resolution_(resolution), start_(Clock::now()) {
+        assert(resolution > Duration::zero());
+        heads_.fill(kNil);
+        tails_.fill(kNil);
+        bitmaps_.fill(0);
+    }
+
+    // Add schedules item to be returned by Pop() at or after the given time point.
+    //
+    // Safe to call from multiple threads.
+    Handle Add(const T& item, TimePoint at) {
+        std::unique_lock lock = Lock();
+        uint32_t index = AllocateNode(item, DeadlineTick(at));
+        Place(index);
+        ++size_;
+        Handle handle(this, TimerId{index, nodes_[index].generation});
+        bool needed2notify = waiters_ > 0 && nodes_[index].expiry < waiting_until_;
+        lock.unlock();
+        if (needed2notify) {
+            var_.notify_one();
+        }
+        return handle;
+    }
+
+    // Pop blocks until some timer expires and returns its item.
+    T Pop() {
+        std::unique_lock lock = Lock();
+        while (true) {
+            Advance(NowTick());
+            if (heads_[kReadyList] != kNil) {
+                uint32_t index = heads_[kReadyList];
+                Unlink(index);
+                T ans = std::move(*nodes_[index].item);
+                FreeNode(index);
+                --size_;
+                bool pass_on = waiters_ > 0 && size_ > 0;
+                lock.unlock();
+                if (pass_on) {
+                    var_.notify_one();
+                }
+                return ans;
+            }
+            ++waiters_;
+            waiting_until_ = size_ ? NextEventTick() : kNever;
+            if (waiting_until_ >= far_tick_) {
+                var_.wait(lock);
+            } else {
+                auto wait_for = resolution_ * static_cast<Duration::rep>(waiting_until_);
+                var_.wait_until(lock, start_ + wait_for);
+            }
+            --waiters_;
+        }
+    }
+
+    // PopAllExpired returns every item whose time has come without blocking.
+    std::vector<T> PopAllExpired() {
+        std::vector<T> expired;
+        std::unique_lock lock = Lock();
+        Advance(NowTick());
+        while (heads_[kReadyList] != kNil) {
+            uint32_t index = heads_[kReadyList];
+            Unlink(index);
+            expired.push_back(std::move(*nodes_[index].item));
+            FreeNode(index);
+            --size_;
+        }
+        return expired;
+    }
+
+    size_t Size() const {
+        std::lock_guard lock(mutex_);
+        return size_;
+    }
+
+    // Counts contention on the wheel lock only; waiting for a deadline is not contention.
+    ContentionSnapshot GetContentionStats() const {
+        return stats_.Snapshot();
+    }
+
+private:
+    friend Handle;
+
+    static constexpr int kSlotBits = 6;
+    static constexpr uint32_t kSlots = 1u << kSlotBits;
+    // Enough levels to cover every 64-bit tick, so there is no overflow list.
+    static constexpr int kLevels = (64 + kSlotBits - 1) / kSlotBits;
+    static constexpr uint32_t kReadyList = kLevels * kSlots;
+    static constexpr uint32_t kFree = std::numeric_limits<uint32_t>::max();
+    static constexpr uint32_t kNil = std::numeric_limits<uint32_t>::max();
+    static constexpr uint64_t kNever = std::numeric_limits<uint64_t>::max();
+
+    struct Node {
+        std::optional<T> item;
+        uint64_t expiry = 0;
+        uint32_t prev = kNil;
+        uint32_t next = kNil;
+        uint32_t list = kFree;
+        uint32_t generation = 0;
+    };
+
+    bool Cancel(TimerId id) {
+        std::unique_lock lock = Lock();
+        if (!IsPending(id)) {
+            return false;
+        }
+        Unlink(id.index);
+        FreeNode(id.index);
+        --size_;
+        return true;
+    }
+
+    bool Reschedule(TimerId id, TimePoint at) {
+        std::unique_lock lock = Lock();
+        if (!IsPending(id)) {
+            return false;
+        }
+        Unlink(id.index);
+        nodes_[id.index].expiry = DeadlineTick(at);
+        Place(id.index);
+        bool needed2notify = waiters_ > 0 && nodes_[id.index].expiry < waiting_until_;
+        lock.unlock();
+        if (needed2notify) {
+            var_.notify_one();
+        }
+        return true;
+    }
+
+    std::unique_lock<std::mutex> Lock() {
+        ContentionScope scope(stats_);
+        return LockCounted(mutex_, scope);
+    }
+
+    bool IsPending(TimerId id) const {
+        return id.index < nodes_.size() && nodes_[id.index].list != kFree &&
+               nodes_[id.index].generation == id.generation;
+    }
+
+    static uint32_t Digit(uint64_t tick, int level) {
+        return static_cast<uint32_t>(tick >> (kSlotBits * level)) & (kSlots - 1);
+    }
+
+    uint64_t DeadlineTick(TimePoint at) const {
+        if (at <= start_) {
+            return 0;
+        }
+        Duration since_start = at - start_;
+        uint64_t tick = since_start / resolution_;
+        if (since_start % resolution_ != Duration::zero()) {
+            ++tick;
+        }
+        return tick;
+    }
+
+    uint64_t NowTick() const {
+        return (Clock::now() - start_) / resolution_;
+    }
+
+    uint32_t AllocateNode(const T& item, uint64_t expiry) {
+        uint32_t index;
+        if (free_head_ != kNil) {
+            index = free_head_;
+            free_head_ = nodes_[index].next;
+        } else {
+            assert(nodes_.size() < kNil);
+            index = static_cast<uint32_t>(nodes_.size());
+            nodes_.emplace_back();
+        }
+        nodes_[index].item.emplace(item);
+        nodes_[index].expiry = expiry;
+        return index;
+    }
+
+    void FreeNode(uint32_t index) {
+        Node& node = nodes_[index];
+        node.item.reset();
+        ++node.generation;
+        node.list = kFree;
+        node.next = free_head_;
+        free_head_ = index;
+    }
+
+    void Link(uint32_t list, uint32_t index) {
+        Node& node = nodes_[index];
+        node.list = list;
+        node.next = kNil;
+        node.prev = tails_[list];
+        if (tails_[list] != kNil) {
+            nodes_[tails_[list]].next = index;
+        } else {
+            heads_[list] = index;
+            if (list != kReadyList) {
+                bitmaps_[list / kSlots] |= uint64_t{1} << (list % kSlots);
+            }
+        }
+        tails_[list] = index;
+    }
+
+    void Unlink(uint32_t index) {
+        Node& node = nodes_[index];
+        uint32_t list = node.list;
+        if (node.prev != kNil) {
+            nodes_[node.prev].next = node.next;
+        } else {
+            heads_[list] = node.next;
+        }
+        if (node.next != kNil) {
+            nodes_[node.next].prev = node.prev;
+        } else {
+            tails_[list] = node.prev;
+        }
+        if (heads_[list] == kNil && list != kReadyList) {
+            bitmaps_[list / kSlots] &= ~(uint64_t{1} << (list % kSlots));
+        }
+    }
+
+    // Place puts a timer on the level where its expiry first differs from the current tick.
+    // Every timer on level L therefore shares all digits above L with cur_ and has a larger
+    // digit at L.
+    void Place(uint32_t index) {
+        uint64_t expiry = nodes_[index].expiry;
+        if (expiry <= cur_) {
+            Link(kReadyList, index);
+            return;
+        }
+        int level = (std::bit_width(expiry ^ cur_) - 1) / kSlotBits;
+        Link(level * kSlots + Digit(expiry, level), index);
+    }
+
+    void Cascade(int level, uint32_t slot) {
+        uint32_t list = level * kSlots + slot;
+        uint32_t index = heads_[list];
+        heads_[list] = tails_[list] = kNil;
+        bitmaps_[level] &= ~(uint64_t{1} << slot);
+        while (index != kNil) {
+            uint32_t next = nodes_[index].next;
+            Place(index);
+            index = next;
+        }
+    }
+
+    // NextEventTick returns the first tick at which some slot has to be fired or cascaded.
+    // Lower levels always hold earlier timers, so the first non-empty level wins.
+    uint64_t NextEventTick() const {
+        for (int level = 0; level < kLevels; ++level) {
+            uint32_t digit = Digit(cur_, level);
+            uint64_t later_slots = bitmaps_[level] & ~((uint64_t{2} << digit) - 1);
+            if (!later_slots) {
+                continue;
+            }
+            int shift = kSlotBits * level;
+            int upper_shift = shift + kSlotBits;
+            uint64_t base = upper_shift >= 64 ? 0 : (cur_ >> upper_shift) << upper_shift;
+            return base | (static_cast<uint64_t>(std::countr_zero(later_slots)) << shift);
+        }
+        return kNever;
+    }
+
+    // Advance moves the wheel to the target tick, jumping straight over empty stretches.
+    void Advance(uint64_t target) {
+        while (cur_ < target) {
+            uint64_t next = NextEventTick();
+            if (next > target) {
+                cur_ = target;
+                return;
+            }
+            cur_ = next;
+            for (int level = kLevels - 1; level >= 0; --level) {
+                uint64_t lower_bits = (uint64_t{1} << (kSlotBits * level)) - 1;
+                if ((cur_ & lower_bits) == 0) {
+                    Cascade(level, Digit(cur_, level));
+                }
+            }
+        }
+    }
+
+    const Duration resolution_;
+    const TimePoint start_;
+    // Ticks past this point do not fit into a TimePoint; waiting for them means waiting forever.
+    const uint64_t far_tick_ = (TimePoint::max() - start_) / resolution_;
+
+    std::vector<Node> nodes_;
+    uint32_t free_head_ = kNil;
+    std::array<uint32_t, kLevels * kSlots + 1> heads_;
+    std::array<uint32_t, kLevels * kSlots + 1> tails_;
+    std::array<uint64_t, kLevels> bitmaps_;
+    uint64_t cur_ = 0;
+    size_t size_ = 0;
+
+    size_t waiters_ = 0;
+    uint64_t waiting_until_ = kNever;
+    std::condition_variable var_;
+    mutable std::mutex mutex_;
+    [[no_unique_address]] ContentionStats stats_;
+};
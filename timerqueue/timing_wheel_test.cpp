@@ -0,0 +1,73 @@
+// Correctness checks for TimingWheel: timers spread over several levels must cascade down and
+// fire in deadline order, never early, and cancelled or rescheduled timers must not fire at
+// their old deadline.
+
+#include "timing_wheel.h"
+#include "../test/check.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+using Wheel = TimingWheel<int>;
+
+// With 10us ticks, level 0 covers 640us and level 2 about 2.6s, so deadlines up to 60ms
+// exercise cascades from levels 1 and 2 in a short run.
+constexpr auto kResolution = std::chrono::microseconds(10);
+constexpr int kTimers = 2000;
+
+void TestCascadeOrder() {
+    Wheel wheel(kResolution);
+    Wheel::TimePoint start = Wheel::Clock::now();
+    std::vector<Wheel::TimePoint> deadlines(kTimers);
+    for (int i = 0; i < kTimers; ++i) {
+        // A fixed permutation of deadlines, so insertion order differs from expiry order.
+        deadlines[i] = start + std::chrono::microseconds((i * 7919 % kTimers) * 30);
+        wheel.Add(i, deadlines[i]);
+    }
+    CHECK(wheel.Size() == kTimers);
+
+    Wheel::TimePoint last = start;
+    for (int popped = 0; popped < kTimers; ++popped) {
+        int item = wheel.Pop();
+        Wheel::TimePoint now = Wheel::Clock::now();
+        CHECK(item >= 0 && item < kTimers);
+        CHECK(deadlines[item] <= now);
+        // Timers of the same tick may come in any order, so compare with a tick of slack.
+        CHECK(deadlines[item] + kResolution > last);
+        last = std::max(last, deadlines[item]);
+        deadlines[item] = Wheel::TimePoint::max();
+    }
+    CHECK(wheel.Size() == 0);
+    CHECK(wheel.PopAllExpired().empty());
+}
+
+void TestCancelAndReschedule() {
+    Wheel wheel(kResolution);
+    Wheel::TimePoint start = Wheel::Clock::now();
+    auto far = wheel.Add(1, start + std::chrono::milliseconds(30));
+    auto cancelled = wheel.Add(2, start + std::chrono::milliseconds(5));
+    auto moved = wheel.Add(3, start + std::chrono::hours(1));
+    CHECK(cancelled.Cancel());
+    CHECK(!cancelled.Cancel());
+    CHECK(moved.Reschedule(start + std::chrono::milliseconds(10)));
+
+    CHECK(wheel.Pop() == 3);
+    CHECK(Wheel::Clock::now() >= start + std::chrono::milliseconds(10));
+    CHECK(wheel.Pop() == 1);
+    CHECK(Wheel::Clock::now() >= start + std::chrono::milliseconds(30));
+    CHECK(!far.Cancel());
+    CHECK(!moved.Reschedule(start));
+    CHECK(wheel.Size() == 0);
+}
+
+}  // namespace
+
+int main() {
+    TestCascadeOrder();
+    TestCancelAndReschedule();
+    return 0;
+}
@@ -9,6 +9,8 @@
 #include <mutex>
 #include <iostream>
 
+#include "../instrumentation/contention.h"
+
 using namespace std::chrono_literals;
 
 template <class T>
@@ -16,7 +18,8 @@ class UnbufferedChannel {
 public:
     using Pair = std::pair<std::shared_ptr<bool>, T>;
     void Send(const T& value) {
-        std::unique_lock send_lock(guard_);
+        ContentionScope scope(stats_);
+        std::unique_lock send_lock = LockCounted(guard_, scope);
         if (!is_opened_.load()) {
             receive_cv_.notify_all();
             send_cv_.notify_all();
@@ -25,13 +28,21 @@ public:
         auto is_received = std::make_shared<bool>(false);
         queue_.push_back(std::make_pair(is_received, value));
         receive_cv_.notify_one();
-        send_cv_.wait(send_lock, [this, &is_received]() { return *is_received; });
+        if (!*is_received) {
+            scope.Block();
+            send_cv_.wait(send_lock, [&is_received]() { return *is_received; });
+        }
         send_cv_.notify_one();
     }
 
     std::optional<T> Recv() {
-        std::unique_lock receive_lock(guard_);
-        receive_cv_.wait(receive_lock, [this]() { return !queue_.empty() || !is_opened_.load(); });
+        ContentionScope scope(stats_);
+        std::unique_lock receive_lock = LockCounted(guard_, scope);
+        auto can_receive = [this]() { return !queue_.empty() || !is_opened_.load(); };
+        if (!can_receive()) {
+            scope.Block();
+            receive_cv_.wait(receive_lock, can_receive);
+        }
         if (!is_opened_.load()) {
             if (queue_.empty()) {
                 receive_cv_.notify_all();
@@ -60,10 +71,17 @@ public:
         receive_cv_.notify_all();
     }
 
+    // Every Send and Recv counts as an acquisition; waiting for the lock or for the other side
+    // of the rendezvous counts as contention.
+    ContentionSnapshot GetContentionStats() const {
+        return stats_.Snapshot();
+    }
+
 private:
     std::atomic<bool> is_opened_{true};
     std::deque<Pair> queue_;
     std::mutex guard_;
     std::condition_variable send_cv_;
     std::condition_variable receive_cv_;
+    [[no_unique_address]] ContentionStats stats_;
 };